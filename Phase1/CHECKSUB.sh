@@ -1,45 +1,66 @@
 #!/bin/sh
+#
+# File:		CHECKSUB.sh
+#
+# Description:	Check a submission against the examples.  We extract the
+#		submission into a directory of our own, compile it, and run
+#		it on every example with the golden runner, which runs the
+#		examples in parallel, reports the time and memory of each,
+#		and shows the differences when an example fails.  The
+#		examples may be a tar file or a directory.
+#
+#		Environment variables:
+#		CXX		compiler for the runner (c++)
+#		JOBS		examples run at once (number of processors)
+#		LIMIT		seconds of processor time for each example (1)
+#		BASELINE	file of times to compare against (none)
+#		UPDATE		if set, write the times to BASELINE instead
+#		THRESHOLD	percent slower than the baseline to flag (25)
+#
 
-PATH=/bin:/usr/bin
-WORKDIR=/tmp/coen175.$LOGNAME
+HERE=`cd "\`dirname "$0"\`" && pwd`
+CXX=${CXX:-c++}
+JOBS=${JOBS:-`nproc 2>/dev/null || getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1`}
+LIMIT=${LIMIT:-1}
+THRESHOLD=${THRESHOLD:-25}
+WORKDIR=`mktemp -d "${TMPDIR:-/tmp}/checksub.XXXXXX"` || exit 1
 
-function die() {
-    rm -rf $WORKDIR
-    exit 1
-}
-
-trap die 2
+trap 'rm -rf "$WORKDIR"' 0
+trap 'exit 1' 2 15
 
 if [ $# -ne 2 ]; then
     echo "$0 submission-file examples-file" 1>&2
     exit 1
 fi
 
-rm -rf $WORKDIR && mkdir -m 700 $WORKDIR && mkdir $WORKDIR/examples || die
-
-echo "Checking environment ..."
-hostname -f | grep 'linux.*.engr.scu.edu' >/dev/null ||
-    { echo "Must be run on an ECC Linux system" 1>&2; die; }
+case "$BASELINE" in
+    ""|/*) ;;
+    *) BASELINE=`pwd`/$BASELINE ;;
+esac
 
 echo "Checking submission ..."
-test -r $1 && test `wc -c < $1` -gt 1000000 \
-    && echo "Submission too large" 1>&2 && die
+test -r "$1" || { echo "Cannot read $1" 1>&2; exit 1; }
+test `wc -c < "$1"` -gt 1000000 && { echo "Submission too large" 1>&2; exit 1; }
 
 echo "Extracting submission ..."
-tar -C $WORKDIR -xf $1 || die
+tar -C "$WORKDIR" -xf "$1" || exit 1
 
 echo "Compiling project ..."
-(cd $WORKDIR && cd phase1 && rm -f *.o scc core && make) || die
+(cd "$WORKDIR/phase1" && rm -f *.o scc core && make) || exit 1
+
+echo "Compiling runner ..."
+$CXX -O2 -std=c++11 -o "$WORKDIR/golden" "$HERE/golden.cpp" || exit 1
 
 echo "Extracting examples ..."
-tar -C $WORKDIR -xf $2 || die
+if [ -d "$2" ]; then
+    mkdir "$WORKDIR/examples" && cp "$2"/*.c "$2"/*.out "$WORKDIR/examples" || exit 1
+else
+    tar -C "$WORKDIR" -xf "$2" || exit 1
+fi
+
+set -- -j "$JOBS" -l "$LIMIT" -t "$THRESHOLD"
+test -n "$BASELINE" && set -- "$@" -b "$BASELINE"
+test -n "$BASELINE" && test -n "$UPDATE" && set -- "$@" -w
 
 echo "Running examples ..."
-(cd $WORKDIR/examples && for FILE in *.c; do
-    echo -n "$FILE ... "
-    (ulimit -t 1; ../phase1/scc) < $FILE 2>/dev/null |
-	cmp -s - `basename $FILE .c`.out 2>/dev/null && echo ok || echo failed
-done)
-
-rm -rf $WORKDIR
-exit 0
+(cd "$WORKDIR/examples" && ../golden "$@" . ../phase1/scc)
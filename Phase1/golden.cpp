@@ -0,0 +1,460 @@
+/*
+ * File:	golden.cpp
+ *
+ * Description:	This file contains a runner of the examples of a phase of
+ *		Simple C, which runs the compiler on every example in a
+ *		directory and compares what it writes to the standard output
+ *		with the expected output of the example:
+ *
+ *		golden [options] directory command [args ...]
+ *
+ *		-j jobs		run this many examples at once (processors)
+ *		-l seconds	limit on the processor time of each run, or
+ *				zero for no limit (1)
+ *		-b baseline	compare the times against a baseline file
+ *		-w		write the times to the baseline file instead
+ *		-t percent	slowdown from the baseline to flag (25)
+ *
+ *		An example is a file ending in .c, and its expected output
+ *		is the file of the same name ending in .out.  Each example
+ *		is given as the standard input of the command.  If there is
+ *		also a file ending in .err, what the command writes to the
+ *		standard error must match it too; otherwise the standard
+ *		error is ignored.  For each example
+ *		we report whether it passed, how long it took on the wall,
+ *		and the most memory the compiler used, and show the
+ *		differences if it failed.
+ *
+ *		A baseline has a line for each example with its name and
+ *		time in milliseconds.  An example is flagged as slower if
+ *		it took more than the given percentage longer than its
+ *		baseline, and more than a few milliseconds longer, so that
+ *		the noise in timing small examples is not flagged.  Running
+ *		examples at once makes each one slower, so a baseline should
+ *		be written and compared with the same number of jobs.
+ *
+ *		The exit status is zero only if every example passed and
+ *		none was slower.
+ */
+
+# include <algorithm>
+# include <cerrno>
+# include <chrono>
+# include <cstdio>
+# include <cstdlib>
+# include <cstring>
+# include <fstream>
+# include <map>
+# include <sstream>
+# include <string>
+# include <vector>
+# include <dirent.h>
+# include <fcntl.h>
+# include <signal.h>
+# include <sys/resource.h>
+# include <sys/wait.h>
+# include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+struct Example {
+    string name;
+    FILE *output, *errors;
+    pid_t pid;
+    steady_clock::time_point start;
+    double time;
+    long memory;
+    int status;
+};
+
+static const double noise = 5.0;
+static unsigned jobs, limit = 1, threshold = 25;
+static const char *baseline;
+static bool writing;
+
+static map<string, double> times;
+static unsigned passed, failed, slower;
+
+
+/*
+ * Function:	examples
+ *
+ * Description:	Return the examples in the given directory in order.
+ */
+
+static vector<Example> examples(const string &directory)
+{
+    vector<Example> result;
+    struct dirent *entry;
+    Example example;
+    string name;
+    DIR *dir;
+
+
+    if ((dir = opendir(directory.c_str())) == nullptr)
+	return result;
+
+    while ((entry = readdir(dir)) != nullptr) {
+	name = entry->d_name;
+
+	if (name.size() > 2 && name.compare(name.size() - 2, 2, ".c") == 0) {
+	    example.name = name;
+	    result.push_back(example);
+	}
+    }
+
+    closedir(dir);
+
+    sort(result.begin(), result.end(), [](const Example &a, const Example &b) {
+	return a.name < b.name;
+    });
+
+    return result;
+}
+
+
+/*
+ * Function:	start
+ *
+ * Description:	Start the command on an example, with its output and its
+ *		errors going to temporary files, and return whether we
+ *		could.
+ */
+
+static bool start(const string &directory, Example &example, char *command[])
+{
+    struct rlimit rl;
+    int input;
+
+
+    if ((example.output = tmpfile()) == nullptr)
+	return false;
+
+    if ((example.errors = tmpfile()) == nullptr) {
+	fclose(example.output);
+	return false;
+    }
+
+    fcntl(fileno(example.output), F_SETFD, FD_CLOEXEC);
+    fcntl(fileno(example.errors), F_SETFD, FD_CLOEXEC);
+
+    if ((input = open((directory + "/" + example.name).c_str(), O_RDONLY | O_CLOEXEC)) < 0) {
+	fclose(example.output);
+	fclose(example.errors);
+	return false;
+    }
+
+    fflush(stdout);
+    example.start = steady_clock::now();
+
+    if ((example.pid = fork()) < 0) {
+	close(input);
+	fclose(example.output);
+	fclose(example.errors);
+	return false;
+    }
+
+    if (example.pid == 0) {
+	dup2(input, 0);
+	dup2(fileno(example.output), 1);
+	dup2(fileno(example.errors), 2);
+	close(input);
+
+	if (limit > 0) {
+	    rl.rlim_cur = rl.rlim_max = limit;
+	    setrlimit(RLIMIT_CPU, &rl);
+	}
+
+	execvp(command[0], command);
+	_exit(127);
+    }
+
+    close(input);
+    return true;
+}
+
+
+/*
+ * Function:	finish
+ *
+ * Description:	Wait for any running example to finish, keeping its time
+ *		and memory, and return whether we could.
+ */
+
+static bool finish(vector<Example *> &running)
+{
+    struct rusage usage;
+    Example *example;
+    int status;
+    pid_t pid;
+
+
+    while ((pid = wait4(-1, &status, 0, &usage)) < 0)
+	if (errno != EINTR)
+	    return false;
+
+    for (unsigned i = 0; i < running.size(); i ++)
+	if (running[i]->pid == pid) {
+	    example = running[i];
+	    running.erase(running.begin() + i);
+	    example->time = duration<double, milli>(steady_clock::now() - example->start).count();
+	    example->memory = usage.ru_maxrss;
+	    example->status = status;
+	    return true;
+	}
+
+    return finish(running);
+}
+
+
+/*
+ * Function:	same
+ *
+ * Description:	Return whether the output of an example is the same as the
+ *		given file.
+ */
+
+static bool same(FILE *output, const string &path)
+{
+    ifstream expected(path, ios::binary);
+    stringstream ss;
+    string actual;
+    char buf[4096];
+    size_t n;
+
+
+    if (!expected)
+	return false;
+
+    rewind(output);
+
+    while ((n = fread(buf, 1, sizeof(buf), output)) > 0)
+	actual.append(buf, n);
+
+    ss << expected.rdbuf();
+    return actual == ss.str();
+}
+
+
+/*
+ * Function:	difference
+ *
+ * Description:	Show the differences between the expected output and the
+ *		output of an example.
+ */
+
+static void difference(FILE *output, const string &path)
+{
+    pid_t pid;
+    int status;
+
+
+    rewind(output);
+    fflush(stdout);
+
+    if ((pid = fork()) == 0) {
+	dup2(fileno(output), 0);
+	execlp("diff", "diff", "-u", path.c_str(), "-", (char *) nullptr);
+	_exit(127);
+    }
+
+    if (pid > 0)
+	waitpid(pid, &status, 0);
+}
+
+
+/*
+ * Function:	readBaseline
+ *
+ * Description:	Read the times in the baseline file, if there is one.
+ */
+
+static map<string, double> readBaseline()
+{
+    map<string, double> times;
+    ifstream in(baseline);
+    string name;
+    double time;
+
+
+    while (in >> name >> time)
+	times[name] = time;
+
+    return times;
+}
+
+
+/*
+ * Function:	writeBaseline
+ *
+ * Description:	Write the times of the examples to the baseline file.
+ */
+
+static bool writeBaseline(const vector<Example> &all)
+{
+    ofstream out(baseline);
+    char buf[64];
+
+
+    for (auto &example : all) {
+	snprintf(buf, sizeof(buf), "%.3f", example.time);
+	out << example.name << " " << buf << "\n";
+    }
+
+    return (bool) out.flush();
+}
+
+
+/*
+ * Function:	report
+ *
+ * Description:	Report on an example that has finished, showing the
+ *		differences if it failed, and flagging it if it was slower
+ *		than its baseline.  The errors are compared only if the
+ *		example has a file of expected errors.
+ */
+
+static void report(const string &directory, Example &example)
+{
+    string stem = directory + "/" + example.name.substr(0, example.name.size() - 2);
+    string expected = stem + ".out", errors = stem + ".err";
+    bool checking = access(errors.c_str(), R_OK) == 0;
+    const char *result;
+    char buf[128];
+
+
+    if (WIFSIGNALED(example.status))
+	result = WTERMSIG(example.status) == SIGXCPU || WTERMSIG(example.status) == SIGKILL
+	    ? "timed out" : "crashed";
+    else if (WEXITSTATUS(example.status) == 127)
+	result = "not run";
+    else if (access(expected.c_str(), R_OK) < 0)
+	result = "no output";
+    else if (!same(example.output, expected))
+	result = "failed";
+    else if (checking && !same(example.errors, errors))
+	result = "failed";
+    else
+	result = "ok";
+
+    snprintf(buf, sizeof(buf), "%-24s %-10s %9.1f ms %9.1f MB", example.name.c_str(),
+	    result, example.time, example.memory / 1024.0);
+    fputs(buf, stdout);
+
+    if (times.count(example.name) > 0) {
+	double base = times[example.name];
+
+	if (example.time > base * (1 + threshold / 100.0) && example.time - base > noise) {
+	    printf("   slower (was %.1f ms)", base);
+	    slower ++;
+	}
+    }
+
+    printf("\n");
+
+    if (strcmp(result, "ok") == 0)
+	passed ++;
+    else {
+	if (strcmp(result, "failed") == 0) {
+	    difference(example.output, expected);
+
+	    if (checking)
+		difference(example.errors, errors);
+	}
+
+	failed ++;
+    }
+
+    fclose(example.output);
+    fclose(example.errors);
+    example.output = example.errors = nullptr;
+}
+
+
+/*
+ * Function:	run
+ *
+ * Description:	Run the command on every example in the directory, with
+ *		as many at once as we have jobs.  Each example is reported
+ *		once it and every example before it have finished, so the
+ *		report is in order however the examples finish.
+ */
+
+static int run(const string &directory, char *command[])
+{
+    vector<Example> all = examples(directory);
+    vector<Example *> running;
+    unsigned next = 0, reported = 0;
+
+
+    if (all.empty()) {
+	fprintf(stderr, "golden: no examples in %s\n", directory.c_str());
+	return EXIT_FAILURE;
+    }
+
+    if (baseline != nullptr && !writing)
+	times = readBaseline();
+
+    while (reported < all.size()) {
+	while (next < all.size() && running.size() < jobs) {
+	    if (!start(directory, all[next], command)) {
+		perror("golden");
+		return EXIT_FAILURE;
+	    }
+
+	    running.push_back(&all[next ++]);
+	}
+
+	if (!finish(running)) {
+	    perror("golden");
+	    return EXIT_FAILURE;
+	}
+
+	while (reported < next && find(running.begin(), running.end(), &all[reported]) == running.end())
+	    report(directory, all[reported ++]);
+    }
+
+    printf("%lu examples, %u passed, %u failed", (unsigned long) all.size(), passed, failed);
+    printf(baseline != nullptr && !writing ? ", %u slower\n" : "\n", slower);
+
+    if (writing && !writeBaseline(all)) {
+	fprintf(stderr, "golden: cannot write %s\n", baseline);
+	return EXIT_FAILURE;
+    }
+
+    return failed == 0 && slower == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Run the examples in a directory.
+ */
+
+int main(int argc, char *argv[])
+{
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int c;
+
+
+    jobs = processors > 0 ? processors : 1;
+
+    while ((c = getopt(argc, argv, "+j:l:b:wt:")) != -1)
+	switch (c) {
+	case 'j': jobs = max(atoi(optarg), 1); break;
+	case 'l': limit = atoi(optarg); break;
+	case 'b': baseline = optarg; break;
+	case 'w': writing = true; break;
+	case 't': threshold = atoi(optarg); break;
+	default: argc = 0; break;
+	}
+
+    if (argc - optind >= 2 && (!writing || baseline != nullptr))
+	return run(argv[optind], argv + optind + 1);
+
+    fprintf(stderr, "usage: %s [-j jobs] [-l seconds] [-b baseline [-w]] [-t percent]\n", argv[0]);
+    fprintf(stderr, "       directory command [args ...]\n");
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+/*
+ * File:	Arena.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		arenas in Simple C.
+ *
+ *		Each chunk starts with a header linking it to the next
+ *		chunk, and the rest of it is handed out in order.  An
+ *		allocation too large for a chunk gets a chunk of its own.
+ *		Chunks come from the global new, so that they are accounted
+ *		for along with everything else when counting (stats.h).
+ */
+
+# include <cassert>
+# include <cstdint>
+# include "Arena.h"
+
+static const size_t chunkSize = 64 * 1024;
+
+
+/*
+ * Function:	Arena::Arena (constructor)
+ *
+ * Description:	Initialize this arena object.  No memory is allocated
+ *		until it is needed.
+ */
+
+Arena::Arena()
+    : _chunks(nullptr), _free(nullptr), _next(nullptr), _limit(nullptr),
+      _finalizers(nullptr)
+{
+}
+
+
+/*
+ * Function:	Arena::~Arena (destructor)
+ *
+ * Description:	Release every object in this arena and deallocate its
+ *		chunks.
+ */
+
+Arena::~Arena()
+{
+    release();
+
+    while (_free != nullptr) {
+	Chunk *chunk = _free;
+	_free = chunk->next;
+	::operator delete(chunk);
+    }
+}
+
+
+/*
+ * Function:	Arena::grow
+ *
+ * Description:	Start a new chunk that can hold at least SIZE bytes after
+ *		its header, reusing a free chunk if one is large enough.
+ */
+
+void Arena::grow(size_t size)
+{
+    Chunk *chunk, **p;
+
+
+    size += sizeof(Chunk) + alignof(std::max_align_t);
+
+    for (p = &_free; *p != nullptr; p = &(*p)->next)
+	if ((*p)->size >= size)
+	    break;
+
+    if (*p != nullptr) {
+	chunk = *p;
+	*p = chunk->next;
+
+    } else {
+	if (size < chunkSize)
+	    size = chunkSize;
+
+	chunk = static_cast<Chunk *>(::operator new(size));
+	chunk->size = size;
+    }
+
+    chunk->next = _chunks;
+    _chunks = chunk;
+    _next = reinterpret_cast<char *>(chunk + 1);
+    _limit = reinterpret_cast<char *>(chunk) + chunk->size;
+}
+
+
+/*
+ * Function:	Arena::allocate
+ *
+ * Description:	Return SIZE bytes of memory with the given ALIGNMENT, which
+ *		must be a power of two no greater than that of any type.
+ */
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    uintptr_t address;
+
+
+    assert(alignment <= alignof(std::max_align_t));
+    address = (reinterpret_cast<uintptr_t>(_next) + alignment - 1) & ~(alignment - 1);
+
+    if (_next == nullptr || address + size > reinterpret_cast<uintptr_t>(_limit)) {
+	grow(size);
+	address = (reinterpret_cast<uintptr_t>(_next) + alignment - 1) & ~(alignment - 1);
+    }
+
+    _next = reinterpret_cast<char *>(address + size);
+    return reinterpret_cast<void *>(address);
+}
+
+
+/*
+ * Function:	Arena::release
+ *
+ * Description:	Destroy every object in this arena, newest first, and keep
+ *		its chunks for reuse.
+ */
+
+void Arena::release()
+{
+    while (_finalizers != nullptr) {
+	Finalizer *finalizer = _finalizers;
+	_finalizers = finalizer->next;
+	finalizer->destroy(finalizer->object);
+    }
+
+    while (_chunks != nullptr) {
+	Chunk *chunk = _chunks;
+	_chunks = chunk->next;
+	chunk->next = _free;
+	_free = chunk;
+    }
+
+    _next = _limit = nullptr;
+}
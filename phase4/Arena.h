@@ -0,0 +1,77 @@
+/*
+ * File:	Arena.h
+ *
+ * Description:	This file contains the class definition for arenas in
+ *		Simple C.  An arena allocates objects by bumping a pointer
+ *		through large chunks of memory, and releases them all at
+ *		once.  The destructors of the objects that need them are
+ *		run in the reverse order of construction when the arena is
+ *		released, so an arena can hold strings and vectors as well.
+ *
+ *		A released arena keeps its chunks to reuse them, so an
+ *		arena that is released after each function only ever holds
+ *		as much memory as the largest function needs.
+ *
+ *		An arena is not thread safe, so each thread should have
+ *		its own.
+ */
+
+# ifndef ARENA_H
+# define ARENA_H
+# include <cstddef>
+# include <new>
+# include <type_traits>
+# include <utility>
+
+class Arena {
+    struct Chunk {
+	Chunk *next;
+	size_t size;
+    };
+
+    struct Finalizer {
+	void (*destroy)(void *object);
+	void *object;
+	Finalizer *next;
+    };
+
+    Chunk *_chunks, *_free;
+    char *_next, *_limit;
+    Finalizer *_finalizers;
+
+    void grow(size_t size);
+
+    template<class T>
+    static void destroy(void *object) {
+	static_cast<T *>(object)->~T();
+    }
+
+public:
+    Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator =(const Arena &) = delete;
+    ~Arena();
+
+    void *allocate(size_t size, size_t alignment);
+    void release();
+
+    template<class T, class... Args>
+    T *make(Args &&... args) {
+	T *object = new (allocate(sizeof(T), alignof(T)))
+	    T(std::forward<Args>(args)...);
+
+	if (!std::is_trivially_destructible<T>::value) {
+	    Finalizer *finalizer = new (allocate(sizeof(Finalizer),
+		    alignof(Finalizer))) Finalizer;
+
+	    finalizer->destroy = destroy<T>;
+	    finalizer->object = object;
+	    finalizer->next = _finalizers;
+	    _finalizers = finalizer;
+	}
+
+	return object;
+    }
+};
+
+# endif /* ARENA_H */
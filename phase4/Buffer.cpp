@@ -0,0 +1,173 @@
+/*
+ * File:	Buffer.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		token buffers in Simple C.
+ */
+
+# include <cassert>
+# include <mutex>
+# include "Buffer.h"
+# include "tokens.h"
+# include "lexer.h"
+# include "stats.h"
+
+using namespace std;
+
+static mutex lexing;
+
+
+/*
+ * Function:	Buffer::read
+ *
+ * Description:	Read tokens from the lexer up to and including the end of
+ *		the input.  Diagnostics reported while reading a token are
+ *		captured rather than written, and are kept with the token.
+ */
+
+void Buffer::read()
+{
+    MemoryTag tag(Memory::TOKENS);
+    Diagnostics captured, *saved;
+    const int *line;
+    int kind;
+
+
+    saved = diagnostics;
+    line = location;
+    diagnostics = &captured;
+    location = &yylineno;
+
+    do {
+	kind = yylex();
+	_tokens.push_back(Token {kind, yylineno,
+		kind == DONE ? yyoffset : yyoffset - yyleng, yytext});
+
+	if (captured.size() > 0) {
+	    _messages[_tokens.size() - 1] = captured;
+	    captured = Diagnostics();
+	}
+
+    } while (kind != DONE);
+
+    diagnostics = saved;
+    location = line;
+}
+
+
+/*
+ * Function:	Buffer::restart
+ *
+ * Description:	Read the tokens of an open file, which starts at the given
+ *		line and offset, replacing any tokens already in this
+ *		buffer.  The lexer is restarted on the file, so this may be
+ *		called from any thread, but it is locked against being used
+ *		by two threads at once.
+ */
+
+void Buffer::restart(FILE *fp, int line, unsigned offset)
+{
+    lock_guard<mutex> guard(lexing);
+
+
+    _tokens.clear();
+    _messages.clear();
+
+    yyrestart(fp);
+    yylineno = line;
+    yyoffset = offset;
+    read();
+}
+
+
+/*
+ * Function:	Buffer::read
+ *
+ * Description:	Read the tokens of the file at the given path, replacing
+ *		any tokens already in this buffer, and return whether the
+ *		file could be opened.
+ */
+
+bool Buffer::read(const string &path)
+{
+    FILE *fp;
+
+
+    if ((fp = fopen(path.c_str(), "r")) == nullptr)
+	return false;
+
+    restart(fp, 1, 0);
+    fclose(fp);
+    return true;
+}
+
+
+/*
+ * Function:	Buffer::scan
+ *
+ * Description:	Read the tokens of the given source, which is already in
+ *		memory, replacing any tokens already in this buffer, and
+ *		return whether we could.  The source may be part of a
+ *		larger one, starting at the given line and offset.  Tokens
+ *		with the space around them rarely take less than four
+ *		characters, so we make room for them at once rather than
+ *		moving them each time the buffer grows.
+ */
+
+bool Buffer::scan(const string &source, int line, unsigned offset)
+{
+    FILE *fp;
+
+
+    if (source.empty())
+	fp = fopen("/dev/null", "r");
+    else
+	fp = fmemopen((void *) source.data(), source.size(), "r");
+
+    if (fp == nullptr)
+	return false;
+
+    _tokens.reserve(source.size() / 4 + 1);
+    restart(fp, line, offset);
+    fclose(fp);
+    return true;
+}
+
+
+/*
+ * Function:	Buffer::size (accessor)
+ *
+ * Description:	Return the number of tokens in this buffer.
+ */
+
+unsigned Buffer::size() const
+{
+    return _tokens.size();
+}
+
+
+/*
+ * Function:	Buffer::operator []
+ *
+ * Description:	Return the token at the given index.
+ */
+
+const Token &Buffer::operator [](unsigned index) const
+{
+    assert(index < _tokens.size());
+    return _tokens[index];
+}
+
+
+/*
+ * Function:	Buffer::messages
+ *
+ * Description:	Return the diagnostics reported while reading the token at
+ *		the given index, or a null pointer if there were none.
+ */
+
+const Diagnostics *Buffer::messages(unsigned index) const
+{
+    auto it = _messages.find(index);
+    return it != _messages.end() ? &it->second : nullptr;
+}
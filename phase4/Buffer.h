@@ -0,0 +1,56 @@
+/*
+ * File:	Buffer.h
+ *
+ * Description:	This file contains the class definition for token buffers
+ *		in Simple C.  A buffer holds every token of the input along
+ *		with its line number and text, so that the parser can skip
+ *		over a function body and come back to it later, possibly
+ *		on another thread.
+ *
+ *		Any diagnostics reported by the lexer while reading a token
+ *		are kept with that token, so the parser can replay them
+ *		when it reaches the token.  That way they appear in the
+ *		same place as when the parser reads from the lexer itself.
+ *
+ *		Each token also records its offset in the input, so that
+ *		an edit to a source can be matched with the tokens it
+ *		touches, and part of a source can be read on its own.
+ *
+ *		The lexer keeps its state in globals, so only one thread
+ *		at a time may read a file or a source in memory into a
+ *		buffer.
+ */
+
+# ifndef BUFFER_H
+# define BUFFER_H
+# include <cstdio>
+# include <map>
+# include <string>
+# include <vector>
+# include "Diagnostics.h"
+
+struct Token {
+    int kind;
+    int line;
+    unsigned offset;
+    std::string text;
+};
+
+class Buffer {
+
+    std::vector<Token> _tokens;
+    std::map<unsigned, Diagnostics> _messages;
+
+    void restart(FILE *fp, int line, unsigned offset);
+
+public:
+    void read();
+    bool read(const std::string &path);
+    bool scan(const std::string &source, int line = 1, unsigned offset = 0);
+
+    unsigned size() const;
+    const Token &operator [](unsigned index) const;
+    const Diagnostics *messages(unsigned index) const;
+};
+
+# endif /* BUFFER_H */
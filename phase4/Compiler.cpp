@@ -0,0 +1,111 @@
+/*
+ * File:	Compiler.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		compilers in the Simple C library.
+ *
+ *		A compiler checks a source just as the compiler does each
+ *		file it is given, from a buffer on the calling thread, but
+ *		with the output and diagnostics of the thread directed to
+ *		the result for as long as it takes, and with the settings
+ *		of the compiler chosen for the thread instead of the ones
+ *		shared by every thread.
+ */
+
+# include <cstdlib>
+# include <sstream>
+# include "Compiler.h"
+# include "Buffer.h"
+# include "parser.h"
+# include "trace.h"
+
+using namespace std;
+
+
+/*
+ * Function:	Compiler::Compiler (constructor)
+ *
+ * Description:	Initialize this compiler with the default options.
+ */
+
+Compiler::Compiler()
+    : Compiler(Options())
+{
+}
+
+
+/*
+ * Function:	Compiler::Compiler (constructor)
+ *
+ * Description:	Initialize this compiler with the given options.
+ */
+
+Compiler::Compiler(const Options &options)
+    : _options(options)
+{
+    _settings.format = options.format;
+    _settings.limit = options.limit;
+    _settings.unique = options.unique;
+}
+
+
+/*
+ * Function:	Compiler::compile
+ *
+ * Description:	Check the given source, and return the result.  The status
+ *		is the exit status of the compiler, which is a failure only
+ *		if checking stopped early, at a syntax error or the limit on
+ *		errors, or could not start at all, in which case the reason
+ *		is given as well.  The errors are the diagnostics rendered
+ *		as the compiler would write them, located in the file with
+ *		the given NAME if there is one.
+ */
+
+Compiler::Result Compiler::compile(const string &source, const string &name) const
+{
+    const Diagnostics::Settings *settings;
+    Diagnostics collected, *log;
+    ostringstream written, errors;
+    const char *prelude;
+    ostream *out;
+    Buffer tokens;
+    Result result;
+
+
+    out = output;
+    log = diagnostics;
+    output = &written;
+    diagnostics = &collected;
+    settings = Diagnostics::choose(&_settings);
+
+    prelude = _options.prelude.empty() ? nullptr : _options.prelude.c_str();
+    result.status = EXIT_FAILURE;
+
+    if (!tokens.scan(source))
+	result.failure = "cannot read source";
+
+    else {
+	try {
+	    if (checkUnit(tokens, prelude, _options.slots, _options.constants))
+		result.status = EXIT_SUCCESS;
+
+	} catch (PreludeError &) {
+	    result.failure = "cannot read prelude " + _options.prelude;
+	}
+    }
+
+    for (auto diagnostic : Diagnostics::collect({&collected}, result.truncated))
+	result.diagnostics.push_back(Message {diagnostic->line,
+		Diagnostics::rule(diagnostic->id),
+		Diagnostics::message(*diagnostic),
+		Diagnostics::spelling(diagnostic->argument)});
+
+    Diagnostics::render(errors, {&collected}, name);
+    result.output = written.str();
+    result.errors = errors.str();
+
+    Diagnostics::choose(settings);
+    output = out;
+    diagnostics = log;
+    return result;
+}
@@ -0,0 +1,62 @@
+/*
+ * File:	Compiler.h
+ *
+ * Description:	This file contains the class definition for compilers in
+ *		the Simple C library, which let another program check a
+ *		source in memory without running the compiler.  A compiler
+ *		holds the settings it was made with, and compiling a source
+ *		returns everything the compiler would have written, along
+ *		with each diagnostic as a structure.
+ *
+ *		Compiling never exits, and everything it changes belongs to
+ *		the calling thread, so any number of threads may compile at
+ *		once, with the same compiler or with different ones.  Only
+ *		breaking the source into tokens is done one thread at a
+ *		time.
+ */
+
+# ifndef COMPILER_H
+# define COMPILER_H
+# include <string>
+# include <vector>
+# include "Diagnostics.h"
+
+class Compiler {
+    typedef std::string string;
+
+public:
+    struct Options {
+	Diagnostics::Format format = Diagnostics::TEXT;
+	unsigned limit = 0;
+	bool unique = false;
+	bool slots = false;
+	bool constants = false;
+	string prelude;
+    };
+
+    struct Message {
+	int line;
+	string rule;
+	string text;
+	string argument;
+    };
+
+    struct Result {
+	int status;
+	string output, errors, failure;
+	std::vector<Message> diagnostics;
+	bool truncated;
+    };
+
+private:
+    Options _options;
+    Diagnostics::Settings _settings;
+
+public:
+    Compiler();
+    Compiler(const Options &options);
+
+    Result compile(const string &source, const string &name = "") const;
+};
+
+# endif /* COMPILER_H */
@@ -0,0 +1,58 @@
+/*
+ * File:	Constant.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		compile-time constants in Simple C.
+ */
+
+# include <cassert>
+# include "Constant.h"
+
+
+/*
+ * Function:	Constant::Constant (constructor)
+ *
+ * Description:	Initialize this constant as unknown.
+ */
+
+Constant::Constant()
+    : _known(false), _value(0)
+{
+}
+
+
+/*
+ * Function:	Constant::Constant (constructor)
+ *
+ * Description:	Initialize this constant with a known value.
+ */
+
+Constant::Constant(long value)
+    : _known(true), _value(value)
+{
+}
+
+
+/*
+ * Function:	Constant::known (accessor)
+ *
+ * Description:	Return whether the value of this constant is known.
+ */
+
+bool Constant::known() const
+{
+    return _known;
+}
+
+
+/*
+ * Function:	Constant::value (accessor)
+ *
+ * Description:	Return the value of this constant, which must be known.
+ */
+
+long Constant::value() const
+{
+    assert(_known);
+    return _value;
+}
@@ -0,0 +1,25 @@
+/*
+ * File:	Constant.h
+ *
+ * Description:	This file contains the class definition for compile-time
+ *		constants in Simple C.  A constant is the value of an
+ *		expression if it is known when checking, and is unknown
+ *		otherwise.  All integral values fit in a long.
+ */
+
+# ifndef CONSTANT_H
+# define CONSTANT_H
+
+class Constant {
+    bool _known;
+    long _value;
+
+public:
+    Constant();
+    Constant(long value);
+
+    bool known() const;
+    long value() const;
+};
+
+# endif /* CONSTANT_H */
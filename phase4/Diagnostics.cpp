@@ -0,0 +1,490 @@
+/*
+ * File:	Diagnostics.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		logs of diagnostics in Simple C, and the function for
+ *		reporting them.
+ *
+ *		Extra functionality:
+ *		- rendering as text, JSON, or SARIF
+ *		- limiting the number of errors rendered
+ *		- removing duplicate diagnostics
+ *		- naming the file of the diagnostics, if not the standard
+ *		  input
+ *
+ *		Messages and their arguments are interned as atoms in a
+ *		table shared by all threads.  Every message must also be in
+ *		the table of known messages below, so that a message kept
+ *		on disk can be kept as its number there, and can never be
+ *		read back as a format of its own.  A duplicate is a diagnostic
+ *		identical to the one just before it, such as the same error
+ *		cascading from one mistake.  They are kept by default,
+ *		since an error on the same line twice may be two errors.
+ */
+
+# include <cassert>
+# include <cstdio>
+# include <mutex>
+# include <sstream>
+# include <unordered_map>
+# include "lexer.h"
+# include "Diagnostics.h"
+# include "stats.h"
+
+using namespace std;
+
+atomic<int> numerrors(0);
+thread_local Diagnostics *diagnostics;
+thread_local const int *location = &yylineno;
+
+static mutex interning;
+static unordered_map<string, unsigned> atoms;
+static vector<const string *> spellings;
+
+static const char *const formats[] = {
+    "syntax error at end of file",
+    "syntax error at '%s'",
+    "unterminated comment",
+    "integer constant too large",
+    "unknown escape sequence in string constant",
+    "escape sequence out of range in string constant",
+    "unknown escape sequence in character constant",
+    "escape sequence out of range in character constant",
+    "redefinition of '%s'",
+    "redeclaration of '%s'",
+    "conflicting types for '%s'",
+    "'%s' undeclared",
+    "'%s' has type void",
+    "invalid return type",
+    "invalid type for test expression",
+    "lvalue required in expression",
+    "invalid operands to binary '%s'",
+    "invalid operand to unary '%s'",
+    "called object is not a function",
+    "invalid arguments to called function",
+};
+
+static Diagnostics::Settings defaults = {Diagnostics::TEXT, 0, false};
+static thread_local const Diagnostics::Settings *settings = &defaults;
+
+
+/*
+ * Function:	same
+ *
+ * Description:	Return whether two diagnostics are identical.
+ */
+
+static bool same(const Diagnostic &left, const Diagnostic &right)
+{
+    return left.id == right.id && left.argument == right.argument &&
+	left.line == right.line;
+}
+
+
+/*
+ * Function:	Diagnostics::add
+ *
+ * Description:	Add a diagnostic to the end of this log, unless it is a
+ *		duplicate we are removing.
+ */
+
+void Diagnostics::add(const Diagnostic &diagnostic)
+{
+    MemoryTag tag(Memory::DIAGNOSTICS);
+
+
+    if (settings->unique && !_log.empty() && same(_log.back(), diagnostic))
+	return;
+
+    _log.push_back(diagnostic);
+}
+
+
+/*
+ * Function:	Diagnostics::append
+ *
+ * Description:	Add the diagnostics of another log to the end of this log.
+ */
+
+void Diagnostics::append(const Diagnostics &that)
+{
+    for (auto &diagnostic : that._log)
+	add(diagnostic);
+}
+
+
+/*
+ * Function:	Diagnostics::shift
+ *
+ * Description:	Move every diagnostic in this log down by the given
+ *		number of lines, or up if it is negative.
+ */
+
+void Diagnostics::shift(int lines)
+{
+    for (auto &diagnostic : _log)
+	diagnostic.line += lines;
+}
+
+
+/*
+ * Function:	Diagnostics::size (accessor)
+ *
+ * Description:	Return the number of diagnostics in this log.
+ */
+
+unsigned Diagnostics::size() const
+{
+    return _log.size();
+}
+
+
+/*
+ * Function:	Diagnostics::operator []
+ *
+ * Description:	Return the diagnostic at the given index.
+ */
+
+const Diagnostic &Diagnostics::operator [](unsigned index) const
+{
+    assert(index < _log.size());
+    return _log[index];
+}
+
+
+/*
+ * Function:	Diagnostics::atom
+ *
+ * Description:	Return the atom for a string, interning it if it is new.
+ */
+
+unsigned Diagnostics::atom(const string &s)
+{
+    MemoryTag tag(Memory::DIAGNOSTICS);
+    lock_guard<mutex> guard(interning);
+    auto result = atoms.emplace(s, spellings.size());
+
+    if (result.second)
+	spellings.push_back(&result.first->first);
+
+    return result.first->second;
+}
+
+
+/*
+ * Function:	Diagnostics::spelling
+ *
+ * Description:	Return the string for an atom.
+ */
+
+const string &Diagnostics::spelling(unsigned atom)
+{
+    lock_guard<mutex> guard(interning);
+    return *spellings[atom];
+}
+
+
+/*
+ * Function:	Diagnostics::message
+ *
+ * Description:	Return the text of a diagnostic, which is its message with
+ *		its argument substituted.  C++'s stupid streams still don't
+ *		do positional arguments, so we still resort to snprintf.
+ */
+
+string Diagnostics::message(const Diagnostic &diagnostic)
+{
+    char buf[1000];
+
+
+    snprintf(buf, sizeof(buf), spelling(diagnostic.id).c_str(),
+	spelling(diagnostic.argument).c_str());
+
+    return buf;
+}
+
+
+/*
+ * Function:	numbering
+ *
+ * Description:	Return a map from each known message to its number.
+ */
+
+static unordered_map<string, int> numbering()
+{
+    unordered_map<string, int> numbers;
+
+
+    for (unsigned i = 0; i < sizeof(formats) / sizeof(formats[0]); i ++)
+	numbers.emplace(formats[i], i);
+
+    return numbers;
+}
+
+
+/*
+ * Function:	Diagnostics::number
+ *
+ * Description:	Return the number of a message in the table of known
+ *		messages, or -1 if it isn't there.  Every diagnostic
+ *		reported is looked up, so the table is hashed, once, the
+ *		first time it is needed.
+ */
+
+int Diagnostics::number(const string &message)
+{
+    static const unordered_map<string, int> numbers = numbering();
+    auto it = numbers.find(message);
+
+
+    return it != numbers.end() ? it->second : -1;
+}
+
+
+/*
+ * Function:	Diagnostics::known
+ *
+ * Description:	Return the known message with the given number, or a null
+ *		pointer if there is none.
+ */
+
+const char *Diagnostics::known(unsigned number)
+{
+    if (number < sizeof(formats) / sizeof(formats[0]))
+	return formats[number];
+
+    return nullptr;
+}
+
+
+/*
+ * Function:	Diagnostics::configure
+ *
+ * Description:	Set the format for rendering, the maximum number of errors
+ *		to render, with zero for no limit, and whether to remove
+ *		duplicates.  These are the settings of every thread that
+ *		hasn't chosen its own.
+ */
+
+void Diagnostics::configure(Format format, unsigned limit, bool unique)
+{
+    defaults.format = format;
+    defaults.limit = limit;
+    defaults.unique = unique;
+}
+
+
+/*
+ * Function:	Diagnostics::choose
+ *
+ * Description:	Choose the settings of the calling thread, or go back to
+ *		the configured ones if there are none, and return the
+ *		settings chosen before.
+ */
+
+const Diagnostics::Settings *Diagnostics::choose(const Settings *chosen)
+{
+    const Settings *previous = settings;
+
+
+    settings = chosen != nullptr ? chosen : &defaults;
+    return previous == &defaults ? nullptr : previous;
+}
+
+
+/*
+ * Function:	Diagnostics::limit (accessor)
+ *
+ * Description:	Return the maximum number of errors, or zero for no limit.
+ */
+
+unsigned Diagnostics::limit()
+{
+    return settings->limit;
+}
+
+
+/*
+ * Function:	Diagnostics::rule
+ *
+ * Description:	Return the name of the rule for a message.  Atoms are
+ *		numbered in the order in which threads happen to intern
+ *		them, so the name is a hash of the message instead, which
+ *		is the same on every run.
+ */
+
+string Diagnostics::rule(unsigned id)
+{
+    unsigned hash = 2166136261u;
+    char buf[16];
+
+
+    for (unsigned char c : spelling(id))
+	hash = (hash ^ c) * 16777619u;
+
+    snprintf(buf, sizeof(buf), "E%08x", hash);
+    return buf;
+}
+
+
+/*
+ * Function:	Diagnostics::escape
+ *
+ * Description:	Write a string to a stream as a JSON string literal.
+ */
+
+void Diagnostics::escape(ostream &ostr, const string &s)
+{
+    char buf[8];
+
+
+    ostr << '"';
+
+    for (unsigned char c : s)
+	if (c == '"' || c == '\\')
+	    ostr << '\\' << c;
+	else if (c < 0x20) {
+	    snprintf(buf, sizeof(buf), "\\u%04x", c);
+	    ostr << buf;
+	} else
+	    ostr << c;
+
+    ostr << '"';
+}
+
+
+/*
+ * Function:	Diagnostics::collect
+ *
+ * Description:	Return the diagnostics in the given logs that are to be
+ *		rendered, in order, setting whether any were dropped.  A
+ *		diagnostic that duplicates the one before it in another log
+ *		is removed as well, and once the limit is reached, the rest
+ *		are dropped.
+ */
+
+vector<const Diagnostic *> Diagnostics::collect(
+	const vector<const Diagnostics *> &logs, bool &truncated)
+{
+    vector<const Diagnostic *> all;
+    unsigned maximum = settings->limit;
+
+
+    truncated = false;
+
+    for (auto log : logs)
+	for (auto &diagnostic : log->_log) {
+	    if (settings->unique && !all.empty() && same(*all.back(), diagnostic))
+		continue;
+
+	    if (maximum > 0 && all.size() == maximum) {
+		truncated = true;
+		return all;
+	    }
+
+	    all.push_back(&diagnostic);
+	}
+
+    return all;
+}
+
+
+/*
+ * Function:	Diagnostics::render
+ *
+ * Description:	Write the diagnostics in the given logs to a stream in the
+ *		configured format, in a single write.  If a FILE is given,
+ *		each diagnostic is located in it.
+ */
+
+void Diagnostics::render(ostream &ostr, const vector<const Diagnostics *> &logs,
+	const string &file)
+{
+    vector<const Diagnostic *> all;
+    const char *separator = "";
+    Format format = settings->format;
+    bool truncated;
+    ostringstream buf;
+
+
+    all = collect(logs, truncated);
+
+    if (format == TEXT) {
+	for (auto diagnostic : all) {
+	    if (!file.empty())
+		buf << file << ": ";
+
+	    buf << "line " << diagnostic->line << ": " << message(*diagnostic) << "\n";
+	}
+
+	if (truncated)
+	    buf << "too many errors\n";
+
+    } else if (format == JSON) {
+	buf << "{\"diagnostics\": [";
+
+	for (auto diagnostic : all) {
+	    buf << separator << "\n  {";
+
+	    if (!file.empty()) {
+		buf << "\"file\": ";
+		escape(buf, file);
+		buf << ", ";
+	    }
+
+	    buf << "\"line\": " << diagnostic->line;
+	    buf << ", \"id\": \"" << rule(diagnostic->id) << "\", \"message\": ";
+	    escape(buf, message(*diagnostic));
+	    buf << ", \"argument\": ";
+	    escape(buf, spelling(diagnostic->argument));
+	    buf << "}";
+	    separator = ",";
+	}
+
+	buf << "\n], \"count\": " << all.size();
+	buf << ", \"truncated\": " << (truncated ? "true" : "false") << "}\n";
+
+    } else {
+	buf << "{\"version\": \"2.1.0\",\n";
+	buf << " \"$schema\": \"https://json.schemastore.org/sarif-2.1.0.json\",\n";
+	buf << " \"runs\": [{\"tool\": {\"driver\": {\"name\": \"scc\"}},\n";
+	buf << "  \"results\": [";
+
+	for (auto diagnostic : all) {
+	    buf << separator << "\n   {\"ruleId\": \"" << rule(diagnostic->id);
+	    buf << "\", \"level\": \"error\", \"message\": {\"text\": ";
+	    escape(buf, message(*diagnostic));
+	    buf << "}, \"locations\": [{\"physicalLocation\": ";
+	    buf << "{\"artifactLocation\": {\"uri\": ";
+	    escape(buf, file.empty() ? "stdin" : file);
+	    buf << "}, ";
+	    buf << "\"region\": {\"startLine\": " << diagnostic->line << "}}}]}";
+	    separator = ",";
+	}
+
+	buf << "\n  ]}]}\n";
+    }
+
+    const string &text = buf.str();
+    ostr.write(text.data(), text.size());
+    ostr.flush();
+}
+
+
+/*
+ * Function:	report
+ *
+ * Description:	Report an error at the current line with an optional
+ *		string argument.  The log and the line number are per
+ *		thread, so that a function body checked on another thread
+ *		can collect its own diagnostics and report the lines of its
+ *		own tokens.
+ */
+
+void report(const string &str, const string &arg)
+{
+    assert(diagnostics != nullptr);
+    assert(Diagnostics::number(str) >= 0);
+    diagnostics->add(Diagnostic {Diagnostics::atom(str), Diagnostics::atom(arg), *location});
+    numerrors ++;
+}
@@ -0,0 +1,76 @@
+/*
+ * File:	Diagnostics.h
+ *
+ * Description:	This file contains the class definition for logs of
+ *		diagnostics in Simple C, and the declarations for reporting
+ *		them.  A diagnostic is recorded as the atom of its message,
+ *		the atom of its argument, and its line, and is only turned
+ *		into text when all the logs are rendered at the end.
+ *
+ *		Each thread reports to its own log, so reporting needs no
+ *		locking other than for interning new atoms.  The logs are
+ *		then rendered together, in order, in a single write.
+ *
+ *		The settings for rendering are shared by every thread,
+ *		unless a thread chooses its own, as each compiler of the
+ *		library does while it compiles.
+ */
+
+# ifndef DIAGNOSTICS_H
+# define DIAGNOSTICS_H
+# include <atomic>
+# include <ostream>
+# include <string>
+# include <vector>
+
+struct Diagnostic {
+    unsigned id;
+    unsigned argument;
+    int line;
+};
+
+class Diagnostics {
+    typedef std::string string;
+    std::vector<Diagnostic> _log;
+
+public:
+    enum Format { TEXT, JSON, SARIF };
+
+    struct Settings {
+	Format format;
+	unsigned limit;
+	bool unique;
+    };
+
+    void add(const Diagnostic &diagnostic);
+    void append(const Diagnostics &that);
+    void shift(int lines);
+
+    unsigned size() const;
+    const Diagnostic &operator [](unsigned index) const;
+
+    static unsigned atom(const string &s);
+    static const string &spelling(unsigned atom);
+    static string message(const Diagnostic &diagnostic);
+    static int number(const string &message);
+    static const char *known(unsigned number);
+    static string rule(unsigned id);
+    static void escape(std::ostream &ostr, const string &s);
+
+    static void configure(Format format, unsigned limit, bool unique);
+    static const Settings *choose(const Settings *settings);
+    static unsigned limit();
+    static std::vector<const Diagnostic *> collect(
+	    const std::vector<const Diagnostics *> &logs, bool &truncated);
+    static void render(std::ostream &ostr,
+	    const std::vector<const Diagnostics *> &logs,
+	    const string &file = "");
+};
+
+extern std::atomic<int> numerrors;
+extern thread_local Diagnostics *diagnostics;
+extern thread_local const int *location;
+
+extern void report(const std::string &str, const std::string &arg = "");
+
+# endif /* DIAGNOSTICS_H */
@@ -0,0 +1,117 @@
+/*
+ * File:	Layout.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		target data layouts in Simple C.
+ *
+ *		Since constants are computed in a long on the machine we run
+ *		on, no integral type of the target may be wider than that.
+ */
+
+# include <cassert>
+# include <climits>
+# include "tokens.h"
+# include "Layout.h"
+
+const Layout target(1, 4, 8, 8, true);
+
+
+/*
+ * Function:	Layout::Layout (constructor)
+ *
+ * Description:	Initialize this layout object.
+ */
+
+Layout::Layout(unsigned charSize, unsigned intSize, unsigned longSize,
+	unsigned pointerSize, bool signedChar)
+    : _charSize(charSize), _intSize(intSize), _longSize(longSize),
+      _pointerSize(pointerSize), _signedChar(signedChar)
+{
+    assert(longSize <= sizeof(long));
+}
+
+
+/*
+ * Function:	Layout::size
+ *
+ * Description:	Return the size in bytes of a scalar with the given
+ *		specifier.  A void has no size, but we follow GCC and give
+ *		it a size of one.
+ */
+
+unsigned long Layout::size(int specifier) const
+{
+    if (specifier == INT)
+	return _intSize;
+
+    if (specifier == LONG)
+	return _longSize;
+
+    return _charSize;
+}
+
+
+/*
+ * Function:	Layout::size
+ *
+ * Description:	Return the size in bytes of an object of the given type.
+ *		Functions and the error type have no size.
+ */
+
+unsigned long Layout::size(const Type &type) const
+{
+    unsigned long element;
+
+
+    if (type.isError() || type.isFunction())
+	return 0;
+
+    element = type.indirection() > 0 ? _pointerSize : size(type.specifier());
+    return type.isArray() ? element * type.length() : element;
+}
+
+
+/*
+ * Function:	Layout::minimum
+ *
+ * Description:	Return the smallest value of the given specifier.
+ */
+
+long Layout::minimum(int specifier) const
+{
+    if (specifier == CHAR && !_signedChar)
+	return 0;
+
+    return -maximum(specifier) - 1;
+}
+
+
+/*
+ * Function:	Layout::maximum
+ *
+ * Description:	Return the largest value of the given specifier.  We shift
+ *		an unsigned long so a full-width type doesn't overflow.
+ */
+
+long Layout::maximum(int specifier) const
+{
+    unsigned bits = size(specifier) * CHAR_BIT;
+
+    if (specifier == CHAR && !_signedChar)
+	return (1UL << bits) - 1;
+
+    return (1UL << (bits - 1)) - 1;
+}
+
+
+/*
+ * Function:	Layout::contains
+ *
+ * Description:	Return whether the given value fits in the given
+ *		specifier.
+ */
+
+bool Layout::contains(int specifier, long value) const
+{
+    return value >= minimum(specifier) && value <= maximum(specifier);
+}
@@ -0,0 +1,36 @@
+/*
+ * File:	Layout.h
+ *
+ * Description:	This file contains the class definition for the data
+ *		layout of a target machine for Simple C.  A layout gives the
+ *		sizes of the scalar types in bytes, and whether a plain
+ *		char is signed.  From these we get the size of any type and
+ *		the range of values of each integral specifier.
+ *
+ *		The layout of the target we compile for is given by the
+ *		target variable.  It is LP64, like the machines we run on.
+ */
+
+# ifndef LAYOUT_H
+# define LAYOUT_H
+# include "Type.h"
+
+class Layout {
+    unsigned _charSize, _intSize, _longSize, _pointerSize;
+    bool _signedChar;
+
+public:
+    Layout(unsigned charSize, unsigned intSize, unsigned longSize,
+	    unsigned pointerSize, bool signedChar);
+
+    unsigned long size(const Type &type) const;
+    unsigned long size(int specifier) const;
+
+    long minimum(int specifier) const;
+    long maximum(int specifier) const;
+    bool contains(int specifier, long value) const;
+};
+
+extern const Layout target;
+
+# endif /* LAYOUT_H */
@@ -11,10 +11,21 @@
  *
  *		Extra functionality:
  *		- retrieving the vector of symbols
+ *		- hashing the symbols of large scopes
+ *		- counting the slots probed and names compared (stats.h)
+ *		- reserving room for many symbols at once
+ *
+ *		A slot in the hash table holds the hash of a name and the
+ *		position of its symbol in the vector plus one, so an empty
+ *		slot has position zero.  We use linear probing, and a slot
+ *		whose symbol was removed stays in use until the next rehash.
  */
 
 # include <cassert>
 # include "Scope.h"
+# include "stats.h"
+
+static const unsigned threshold = 16;
 
 
 /*
@@ -24,8 +35,172 @@
  */
 
 Scope::Scope(Scope *enclosing)
-    : _enclosing(enclosing)
+    : _enclosing(enclosing), _holes(0), _used(0)
+{
+    stats::create(Object::SCOPE);
+}
+
+
+/*
+ * Function:	Scope::~Scope (destructor)
+ *
+ * Description:	Deallocate this scope object, but not its symbols.
+ */
+
+Scope::~Scope()
 {
+    stats::destroy(Object::SCOPE);
+}
+
+
+/*
+ * Function:	Scope::hash
+ *
+ * Description:	Return the hash of a name.  We use FNV-1a, which is simple
+ *		and good enough for identifiers.
+ */
+
+unsigned Scope::hash(const string &name)
+{
+    unsigned h = 2166136261u;
+
+    for (unsigned i = 0; i < name.size(); i ++)
+	h = (h ^ (unsigned char) name[i]) * 16777619u;
+
+    return h;
+}
+
+
+/*
+ * Function:	Scope::position
+ *
+ * Description:	Return the position plus one of the symbol with the given
+ *		name in the vector, or zero if there is no such symbol.
+ */
+
+unsigned Scope::position(const string &name) const
+{
+    unsigned h, mask;
+    Symbol *symbol;
+
+
+    if (_slots.empty()) {
+	for (unsigned i = 0; i < _symbols.size(); i ++) {
+	    stats::count(Counter::PROBES);
+	    stats::count(Counter::COMPARISONS);
+
+	    if (name == _symbols[i]->name())
+		return i + 1;
+	}
+
+	return 0;
+    }
+
+    h = hash(name);
+    mask = _slots.size() - 1;
+
+    for (unsigned i = h & mask; _slots[i].position != 0; i = (i + 1) & mask) {
+	symbol = _symbols[_slots[i].position - 1];
+	stats::count(Counter::PROBES);
+
+	if (_slots[i].hash == h && symbol != nullptr) {
+	    stats::count(Counter::COMPARISONS);
+
+	    if (name == symbol->name())
+		return _slots[i].position;
+	}
+    }
+
+    return 0;
+}
+
+
+/*
+ * Function:	Scope::index
+ *
+ * Description:	Add a slot for the symbol at the given position plus one.
+ *		The table must have room for it.
+ */
+
+void Scope::index(unsigned position)
+{
+    unsigned h, i, mask;
+
+
+    h = hash(_symbols[position - 1]->name());
+    mask = _slots.size() - 1;
+
+    for (i = h & mask; _slots[i].position != 0; i = (i + 1) & mask)
+	continue;
+
+    _slots[i].hash = h;
+    _slots[i].position = position;
+    _used ++;
+}
+
+
+/*
+ * Function:	Scope::rehash
+ *
+ * Description:	Rebuild the hash table with the given capacity, which must
+ *		be a power of two.
+ */
+
+void Scope::rehash(unsigned capacity)
+{
+    _slots.assign(capacity, Slot {0, 0});
+    _used = 0;
+
+    for (unsigned i = 0; i < _symbols.size(); i ++)
+	if (_symbols[i] != nullptr)
+	    index(i + 1);
+}
+
+
+/*
+ * Function:	Scope::compact
+ *
+ * Description:	Squeeze the holes left by removed symbols out of the
+ *		vector, which moves the symbols, so rebuild the table.
+ */
+
+void Scope::compact()
+{
+    unsigned n = 0;
+
+
+    for (unsigned i = 0; i < _symbols.size(); i ++)
+	if (_symbols[i] != nullptr)
+	    _symbols[n ++] = _symbols[i];
+
+    _symbols.resize(n);
+    _holes = 0;
+    rehash(_slots.size());
+}
+
+
+/*
+ * Function:	Scope::reserve
+ *
+ * Description:	Make room for the given number of symbols in all, so that
+ *		inserting them doesn't rehash the table over and over.
+ */
+
+void Scope::reserve(unsigned count)
+{
+    unsigned capacity = threshold * 4;
+
+
+    _symbols.reserve(count);
+
+    if (count <= threshold)
+	return;
+
+    while (capacity * 3 < count * 4)
+	capacity *= 2;
+
+    if (capacity > _slots.size())
+	rehash(capacity);
 }
 
 
@@ -41,6 +216,15 @@ void Scope::insert(Symbol *symbol)
 {
     assert(find(symbol->name()) == nullptr);
     _symbols.push_back(symbol);
+
+    if (!_slots.empty()) {
+	if ((_used + 1) * 4 > _slots.size() * 3)
+	    rehash(_slots.size() * 2);
+	else
+	    index(_symbols.size());
+
+    } else if (_symbols.size() > threshold)
+	rehash(threshold * 4);
 }
 
 
@@ -53,11 +237,12 @@ void Scope::insert(Symbol *symbol)
 
 Symbol *Scope::find(const string &name) const
 {
-    for (auto symbol : _symbols)
-	if (name == symbol->name())
-	    return symbol;
+    unsigned i;
+
 
-    return nullptr;
+    stats::count(Counter::FINDS);
+    i = position(name);
+    return i != 0 ? _symbols[i - 1] : nullptr;
 }
 
 
@@ -66,15 +251,29 @@ Symbol *Scope::find(const string &name) const
  *
  * Description:	Remove the symbol with the given name from this scope.
  *		And, yes, I didn't use an iterator.  So sue me.
+ *
+ *		If the scope is hashed, we leave a hole rather than shift
+ *		the rest of the vector, and only compact it once it's
+ *		mostly holes.
  */
 
 void Scope::remove(const string &name)
 {
-    for (unsigned i = 0; i < _symbols.size(); i ++)
-	if (name == _symbols[i]->name()) {
-	    _symbols.erase(_symbols.begin() + i);
-	    break;
-	}
+    unsigned i = position(name);
+
+
+    if (i == 0)
+	return;
+
+    if (_slots.empty())
+	_symbols.erase(_symbols.begin() + i - 1);
+
+    else {
+	_symbols[i - 1] = nullptr;
+
+	if (++ _holes * 2 > _symbols.size())
+	    compact();
+    }
 }
 
 
@@ -114,10 +313,24 @@ Scope *Scope::enclosing() const
 /*
  * Function:	Scope::symbols (accessor)
  *
- * Description:	Return the list of symbols in this scope.
+ * Description:	Return the list of symbols in this scope, skipping the
+ *		holes left by removed symbols rather than squeezing them
+ *		out, since a reader shouldn't change the scope.
  */
 
-const Symbols &Scope::symbols() const
+Symbols Scope::symbols() const
 {
-    return _symbols;
+    Symbols symbols;
+
+
+    if (_holes == 0)
+	return _symbols;
+
+    symbols.reserve(_symbols.size() - _holes);
+
+    for (auto symbol : _symbols)
+	if (symbol != nullptr)
+	    symbols.push_back(symbol);
+
+    return symbols;
 }
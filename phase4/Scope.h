@@ -7,6 +7,15 @@
  *		the symbols in insertion order, and we expect the number of
  *		symbols inserted to be small.
  *
+ *		When we're wrong about that, as in the outermost scope of a
+ *		large file, a scan of the vector gets expensive.  So once a
+ *		scope passes a small number of symbols, we also keep an
+ *		open-addressing hash table of positions in the vector.
+ *		Removing a symbol from a hashed scope just leaves a hole in
+ *		the vector, and the holes are squeezed out once they are
+ *		half of it.  The list of symbols handed out is a copy
+ *		without the holes, so reading a scope never changes it.
+ *
  *		Each scope has a link to its enclosing scope.  By
  *		convention, a null scope is used if there is no enclosing
  *		scope.  The find function searches only the given scope,
@@ -24,19 +33,34 @@ typedef std::vector<Symbol *> Symbols;
 class Scope {
     typedef std::string string;
 
+    struct Slot {
+	unsigned hash;
+	unsigned position;
+    };
+
     Scope *_enclosing;
     Symbols _symbols;
+    std::vector<Slot> _slots;
+    unsigned _holes, _used;
+
+    static unsigned hash(const string &name);
+    unsigned position(const string &name) const;
+    void index(unsigned position);
+    void rehash(unsigned capacity);
+    void compact();
 
 public:
     Scope(Scope *enclosing = nullptr);
+    ~Scope();
 
+    void reserve(unsigned count);
     void insert(Symbol *symbol);
     void remove(const string &name);
     Symbol *find(const string &name) const;
     Symbol *lookup(const string &name) const;
 
     Scope *enclosing() const;
-    const Symbols &symbols() const;
+    Symbols symbols() const;
 };
 
 # endif /* SCOPE_H */
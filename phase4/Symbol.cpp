@@ -3,10 +3,11 @@
  *
  * Description:	This file contains the member function definitions for
  *		symbols in Simple C.  At this point, a symbol merely
- *		consists of a name and a type.
+ *		consists of a name, a type, and possibly a slot.
  */
 
 # include "Symbol.h"
+# include "stats.h"
 
 using std::string;
 
@@ -17,9 +18,22 @@ using std::string;
  * Description:	Initialize a symbol object.
  */
 
-Symbol::Symbol(const string &name, const Type &type)
-    : _name(name), _type(type)
+Symbol::Symbol(const string &name, const Type &type, int slot)
+    : _name(name), _type(type), _slot(slot)
 {
+    stats::create(Object::SYMBOL);
+}
+
+
+/*
+ * Function:	Symbol::~Symbol (destructor)
+ *
+ * Description:	Deallocate a symbol object.
+ */
+
+Symbol::~Symbol()
+{
+    stats::destroy(Object::SYMBOL);
 }
 
 
@@ -45,3 +59,15 @@ const Type &Symbol::type() const
 {
     return _type;
 }
+
+
+/*
+ * Function:	Symbol::slot (accessor)
+ *
+ * Description:	Return the slot of this symbol, or -1 if it has none.
+ */
+
+int Symbol::slot() const
+{
+    return _slot;
+}
@@ -4,6 +4,11 @@
  * Description:	This file contains the class definition for symbols in
  *		Simple C.  At this point, a symbol merely consists of a
  *		name and a type, neither of which you can change.
+ *
+ *		A local variable or parameter also has a slot, which is its
+ *		index in the frame of the function that declares it, so it
+ *		can be accessed without looking up its name.  A global has
+ *		no slot.
  */
 
 # ifndef SYMBOL_H
@@ -15,11 +20,14 @@ class Symbol {
     typedef std::string string;
     string _name;
     Type _type;
+    int _slot;
 
 public:
-    Symbol(const string &name, const Type &type);
+    Symbol(const string &name, const Type &type, int slot = -1);
+    ~Symbol();
     const string &name() const;
     const Type &type() const;
+    int slot() const;
 };
 
 # endif /* SYMBOL_H */
@@ -0,0 +1,170 @@
+/*
+ * File:	Table.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		symbol tables in Simple C.
+ *
+ *		The log points directly at the entries of the map, which
+ *		stay put as the map grows.  A name is erased from the map
+ *		once its stack is empty, so the map holds only the names
+ *		bound in the open scopes rather than every name ever seen.
+ */
+
+# include <cassert>
+# include "Table.h"
+
+
+/*
+ * Function:	Table::Table (constructor)
+ *
+ * Description:	Initialize this table with no scopes open.
+ */
+
+Table::Table()
+    : _level(0)
+{
+}
+
+
+/*
+ * Function:	Table::open
+ *
+ * Description:	Open a new innermost scope.
+ */
+
+void Table::open()
+{
+    _level ++;
+}
+
+
+/*
+ * Function:	Table::close
+ *
+ * Description:	Close the innermost scope, unwinding the log to remove
+ *		every binding it made, and erasing any name left unbound.
+ */
+
+void Table::close()
+{
+    Map::value_type *entry;
+
+
+    assert(_level > 0);
+
+    while (!_log.empty() && _log.back()->second.back().level == _level) {
+	entry = _log.back();
+	_log.pop_back();
+	entry->second.pop_back();
+
+	if (entry->second.empty())
+	    _bindings.erase(_bindings.find(entry->first));
+    }
+
+    _level --;
+}
+
+
+/*
+ * Function:	Table::clear
+ *
+ * Description:	Close all scopes.
+ */
+
+void Table::clear()
+{
+    while (_level > 0)
+	close();
+}
+
+
+/*
+ * Function:	Table::insert
+ *
+ * Description:	Bind the given symbol in the innermost scope.  Like
+ *		Scope::insert, it had better not already be bound there.
+ */
+
+void Table::insert(Symbol *symbol)
+{
+    auto it = _bindings.find(symbol->name());
+
+
+    assert(_level > 0 && find(symbol->name()) == nullptr);
+
+    if (it == _bindings.end())
+	it = _bindings.emplace(symbol->name(), Bindings()).first;
+
+    it->second.push_back(Binding {symbol, _level});
+    _log.push_back(&*it);
+}
+
+
+/*
+ * Function:	Table::find
+ *
+ * Description:	Find and return the symbol with the given name in the
+ *		innermost scope.  If no such symbol is found, return a null
+ *		pointer.
+ */
+
+Symbol *Table::find(const string &name) const
+{
+    auto it = _bindings.find(name);
+
+    if (it == _bindings.end() || it->second.empty())
+	return nullptr;
+
+    return it->second.back().level == _level ? it->second.back().symbol : nullptr;
+}
+
+
+/*
+ * Function:	Table::lookup
+ *
+ * Description:	Find and return the innermost symbol with the given name in
+ *		any open scope.  If no such symbol is found, return a null
+ *		pointer.
+ */
+
+Symbol *Table::lookup(const string &name) const
+{
+    auto it = _bindings.find(name);
+
+    if (it == _bindings.end() || it->second.empty())
+	return nullptr;
+
+    return it->second.back().symbol;
+}
+
+
+/*
+ * Function:	Table::depth
+ *
+ * Description:	Return how many scopes out from the innermost one the
+ *		innermost binding of the given name is, or the number of
+ *		open scopes if there is none, as if the name were found in
+ *		the outermost scope.
+ */
+
+unsigned Table::depth(const string &name) const
+{
+    auto it = _bindings.find(name);
+
+    if (it == _bindings.end() || it->second.empty())
+	return _level;
+
+    return _level - it->second.back().level;
+}
+
+
+/*
+ * Function:	Table::level (accessor)
+ *
+ * Description:	Return the number of open scopes.
+ */
+
+unsigned Table::level() const
+{
+    return _level;
+}
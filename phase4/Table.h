@@ -0,0 +1,58 @@
+/*
+ * File:	Table.h
+ *
+ * Description:	This file contains the class definition for symbol tables
+ *		in Simple C.  A table holds the symbols of the scopes nested
+ *		inside the outermost scope, which are the scopes of a
+ *		function and its blocks.  Rather than searching each scope
+ *		in turn, a table maps each name to a stack of its bindings,
+ *		with the innermost binding on top, so any name is found in
+ *		constant time no matter how deeply the scopes are nested.
+ *
+ *		Each binding records the level of the scope that holds it.
+ *		An undo log records the name and stack of each binding made,
+ *		so that closing a scope pops exactly the bindings it made.
+ *
+ *		The outermost scope is not kept in a table, since it can
+ *		change while a function's scope is open and is hashed
+ *		anyway.
+ */
+
+# ifndef TABLE_H
+# define TABLE_H
+# include <string>
+# include <unordered_map>
+# include <vector>
+# include "Symbol.h"
+
+class Table {
+    typedef std::string string;
+
+    struct Binding {
+	Symbol *symbol;
+	unsigned level;
+    };
+
+    typedef std::vector<Binding> Bindings;
+    typedef std::unordered_map<string, Bindings> Map;
+
+    Map _bindings;
+    std::vector<Map::value_type *> _log;
+    unsigned _level;
+
+public:
+    Table();
+
+    void open();
+    void close();
+    void clear();
+
+    void insert(Symbol *symbol);
+    Symbol *find(const string &name) const;
+    Symbol *lookup(const string &name) const;
+    unsigned depth(const string &name) const;
+
+    unsigned level() const;
+};
+
+# endif /* TABLE_H */
@@ -17,14 +17,211 @@
  *		- predicate functions such as isArray()
  *		- stream operator
  *		- the error type
+ *		- interned types with integer handles
+ *		- counting comparisons and promotions (stats.h)
  */
 
 # include <cassert>
+# include <mutex>
+# include <unordered_map>
+# include <unordered_set>
 # include "tokens.h"
 # include "Type.h"
+# include "stats.h"
 
 using namespace std;
 
+/*
+ * A scalar type is encoded in its handle as its specifier and number of
+ * levels of indirection, and the error type is the handle zero.  Since
+ * every specifier is a nonzero token, no scalar type has a zero handle.
+ * Any other type has the top bit set and the rest of the handle is its
+ * index in the table.  The table grows in chunks that are never moved,
+ * so a thread can read an entry without locking the table.
+ */
+
+static const unsigned TABLE = 0x80000000, SHIFT = 16, SPECIFIER = 0xffff;
+static const unsigned CHUNK = 4096, CHUNKS = 32768;
+
+namespace {
+    struct Entry {
+	int specifier;
+	unsigned indirection;
+	unsigned long length;
+	const Parameters *parameters;
+	bool function;
+    };
+
+    struct Hash {
+	size_t operator ()(const Entry &entry) const;
+	size_t operator ()(const Parameters &parameters) const;
+    };
+
+    struct Equal {
+	bool operator ()(const Entry &left, const Entry &right) const;
+	bool operator ()(const Parameters &left, const Parameters &right) const;
+    };
+
+    struct Interned {
+	mutex lock;
+	Entry *chunks[CHUNKS];
+	unsigned count;
+	unordered_map<Entry, unsigned, Hash, Equal> entries;
+	unordered_set<Parameters, Hash, Equal> lists;
+
+	~Interned();
+    };
+}
+
+static Interned interned;
+
+
+/*
+ * Function:	combine
+ *
+ * Description:	Combine a value into a hash.
+ */
+
+static size_t combine(size_t hash, size_t value)
+{
+    return (hash ^ value) * 1099511628211u;
+}
+
+
+/*
+ * Function:	Hash::operator ()
+ *
+ * Description:	Return the hash of an entry in the table.  Parameter lists
+ *		are interned before their entries, so we can simply hash
+ *		the address of the list.
+ */
+
+size_t Hash::operator ()(const Entry &entry) const
+{
+    size_t hash = 14695981039346656037u;
+
+    hash = combine(hash, entry.specifier);
+    hash = combine(hash, entry.indirection);
+    hash = combine(hash, entry.length);
+    hash = combine(hash, (size_t) entry.parameters);
+    return combine(hash, entry.function);
+}
+
+
+/*
+ * Function:	Hash::operator ()
+ *
+ * Description:	Return the hash of a parameter list.
+ */
+
+size_t Hash::operator ()(const Parameters &parameters) const
+{
+    size_t hash = 14695981039346656037u;
+
+    for (auto &parameter : parameters)
+	hash = combine(hash, parameter.handle());
+
+    return hash;
+}
+
+
+/*
+ * Function:	Equal::operator ()
+ *
+ * Description:	Return whether two entries in the table are identical.
+ */
+
+bool Equal::operator ()(const Entry &left, const Entry &right) const
+{
+    return left.specifier == right.specifier &&
+	left.indirection == right.indirection &&
+	left.length == right.length &&
+	left.parameters == right.parameters &&
+	left.function == right.function;
+}
+
+
+/*
+ * Function:	Equal::operator ()
+ *
+ * Description:	Return whether two parameter lists are identical.
+ */
+
+bool Equal::operator ()(const Parameters &left, const Parameters &right) const
+{
+    if (left.size() != right.size())
+	return false;
+
+    for (unsigned i = 0; i < left.size(); i ++)
+	if (left[i].handle() != right[i].handle())
+	    return false;
+
+    return true;
+}
+
+
+/*
+ * Function:	Interned::~Interned (destructor)
+ *
+ * Description:	Deallocate the table, and with it every parameter list.
+ */
+
+Interned::~Interned()
+{
+    for (unsigned i = 0; i < count; i += CHUNK)
+	delete[] chunks[i / CHUNK];
+}
+
+
+/*
+ * Function:	intern
+ *
+ * Description:	Return the handle of the given array or function type,
+ *		adding it to the table if it is not already there.  Its
+ *		parameter list, if any, is replaced by the shared copy.
+ */
+
+static unsigned intern(Entry entry)
+{
+    MemoryTag tag(Memory::TYPES);
+    lock_guard<mutex> guard(interned.lock);
+    unsigned index;
+
+
+    if (entry.parameters != nullptr) {
+	MemoryTag inner(Memory::PARAMETERS);
+	entry.parameters = &*interned.lists.insert(*entry.parameters).first;
+    }
+
+    auto it = interned.entries.find(entry);
+
+    if (it != interned.entries.end())
+	return it->second;
+
+    index = interned.count ++;
+    assert(index < CHUNK * CHUNKS);
+
+    if (index % CHUNK == 0)
+	interned.chunks[index / CHUNK] = new Entry[CHUNK];
+
+    interned.chunks[index / CHUNK][index % CHUNK] = entry;
+    interned.entries.emplace(entry, TABLE | index);
+    return TABLE | index;
+}
+
+
+/*
+ * Function:	lookup
+ *
+ * Description:	Return the entry in the table for the given handle.
+ */
+
+static const Entry &lookup(unsigned handle)
+{
+    unsigned index = handle & ~TABLE;
+    return interned.chunks[index / CHUNK][index % CHUNK];
+}
+
 
 /*
  * Function:	Type::Type (constructor)
@@ -33,7 +230,7 @@ using namespace std;
  */
 
 Type::Type()
-    : _declarator(ERROR)
+    : _handle(0)
 {
 }
 
@@ -45,8 +242,10 @@ Type::Type()
  */
 
 Type::Type(int specifier, unsigned indirection)
-    : _specifier(specifier), _indirection(indirection), _declarator(SCALAR)
+    : _handle(indirection << SHIFT | specifier)
 {
+    assert(specifier > 0 && (unsigned) specifier <= SPECIFIER);
+    assert(indirection < TABLE >> SHIFT);
 }
 
 
@@ -57,57 +256,74 @@ Type::Type(int specifier, unsigned indirection)
  */
 
 Type::Type(int specifier, unsigned indirection, unsigned long length)
-    : _specifier(specifier), _indirection(indirection), _length(length)
+    : _handle(intern(Entry {specifier, indirection, length, nullptr, false}))
 {
-    _declarator = ARRAY;
 }
 
 
 /*
  * Function:	Type::Type (constructor)
  *
- * Description:	Initialize this type object as a function type.
+ * Description:	Initialize this type object as a function type.  The
+ *		parameter list is copied, so it still belongs to the caller.
+ */
+
+Type::Type(int specifier, unsigned indirection, const Parameters *parameters)
+    : _handle(intern(Entry {specifier, indirection, 0, parameters, true}))
+{
+}
+
+
+/*
+ * Function:	Type::valid
+ *
+ * Description:	Return whether a type may have the given specifier and
+ *		number of levels of indirection.  The specifier must be
+ *		one of Simple C's, and there must be room for one more
+ *		level, since an array decays to a pointer.  Types read from
+ *		outside the compiler are checked with this before being
+ *		made, since the constructors only assert.
  */
 
-Type::Type(int specifier, unsigned indirection, Parameters *parameters)
-    : _specifier(specifier), _indirection(indirection), _parameters(parameters)
+bool Type::valid(int specifier, unsigned indirection)
 {
-    _declarator = FUNCTION;
+    if (specifier != CHAR && specifier != INT && specifier != LONG &&
+	    specifier != VOID)
+	return false;
+
+    return indirection + 1 < TABLE >> SHIFT;
 }
 
 
 /*
  * Function:	Type::operator ==
  *
- * Description:	Return whether another type is equal to this type.  The
- *		parameter lists are checked for function types, which C++
- *		makes so easy.  (At least, it makes something easy!)
+ * Description:	Return whether another type is equal to this type.  Since
+ *		types are interned, that is just whether they have the same
+ *		handle, except that a function type with an unspecified
+ *		parameter list is equal to any function type with the same
+ *		result.
  */
 
 bool Type::operator ==(const Type &rhs) const
 {
-    if (_declarator != rhs._declarator)
-	return false;
+    stats::count(Counter::EQUALITIES);
 
-    if (_declarator == ERROR)
+    if (_handle == rhs._handle)
 	return true;
 
-    if (_specifier != rhs._specifier)
+    if (!isFunction() || !rhs.isFunction())
 	return false;
 
-    if (_indirection != rhs._indirection)
-	return false;
+    const Entry &left = lookup(_handle), &right = lookup(rhs._handle);
 
-    if (_declarator == SCALAR)
-	return true;
-
-    if (_declarator == ARRAY)
-	return _length == rhs._length;
+    if (left.specifier != right.specifier)
+	return false;
 
-    if (!_parameters || !rhs._parameters)
-	return true;
+    if (left.indirection != right.indirection)
+	return false;
 
-    return *_parameters == *rhs._parameters;
+    return !left.parameters || !right.parameters;
 }
 
 
@@ -133,7 +349,7 @@ bool Type::operator !=(const Type &rhs) const
 
 bool Type::isArray() const
 {
-    return _declarator == ARRAY;
+    return (_handle & TABLE) && !lookup(_handle).function;
 }
 
 
@@ -145,7 +361,7 @@ bool Type::isArray() const
 
 bool Type::isScalar() const
 {
-    return _declarator == SCALAR;
+    return _handle != 0 && !(_handle & TABLE);
 }
 
 
@@ -157,7 +373,7 @@ bool Type::isScalar() const
 
 bool Type::isFunction() const
 {
-    return _declarator == FUNCTION;
+    return (_handle & TABLE) && lookup(_handle).function;
 }
 
 
@@ -169,7 +385,7 @@ bool Type::isFunction() const
 
 bool Type::isError() const
 {
-    return _declarator == ERROR;
+    return _handle == 0;
 }
 
 
@@ -181,7 +397,10 @@ bool Type::isError() const
 
 int Type::specifier() const
 {
-    return _specifier;
+    if (_handle & TABLE)
+	return lookup(_handle).specifier;
+
+    return _handle & SPECIFIER;
 }
 
 
@@ -193,7 +412,10 @@ int Type::specifier() const
 
 unsigned Type::indirection() const
 {
-    return _indirection;
+    if (_handle & TABLE)
+	return lookup(_handle).indirection;
+
+    return _handle >> SHIFT;
 }
 
 
@@ -207,8 +429,8 @@ unsigned Type::indirection() const
 
 unsigned long Type::length() const
 {
-    assert(_declarator == ARRAY);
-    return _length;
+    assert(isArray());
+    return lookup(_handle).length;
 }
 
 
@@ -219,10 +441,22 @@ unsigned long Type::length() const
  *		function type.
  */
 
-Parameters *Type::parameters() const
+const Parameters *Type::parameters() const
+{
+    assert(isFunction());
+    return lookup(_handle).parameters;
+}
+
+
+/*
+ * Function:	Type::handle (accessor)
+ *
+ * Description:	Return the handle of this type.
+ */
+
+unsigned Type::handle() const
 {
-    assert(_declarator == FUNCTION);
-    return _parameters;
+    return _handle;
 }
 
 /**
@@ -245,7 +479,7 @@ bool Type::isPredicate() const
 */
 bool Type::isPointer() const
 {
-    return (_declarator == SCALAR && _indirection > 0) || _declarator == ARRAY;
+    return (isScalar() && indirection() > 0) || isArray();
 
 }
 
@@ -257,7 +491,7 @@ bool Type::isPointer() const
 */
 bool Type::isNumeric() const
 {
-    return (_declarator == SCALAR && _indirection == 0 && _specifier != VOID);
+    return (isScalar() && indirection() == 0 && specifier() != VOID);
 }
 
 /**
@@ -317,13 +551,15 @@ bool Type::isCompatibleWith(const Type &that) const {
 */
 Type Type::promote() const
 {        
+    stats::count(Counter::PROMOTIONS);
+
     // promote char to int
-    if(_specifier == CHAR && _declarator == SCALAR) {
+    if(specifier() == CHAR && isScalar()) {
         return Type(INT);
     }
     // promote array to pointer
-    if(_declarator == ARRAY) {
-        return Type(_specifier, _indirection + 1);
+    if(isArray()) {
+        return Type(specifier(), indirection() + 1);
     }
 
     return *this;
@@ -365,3 +601,29 @@ ostream &operator <<(ostream &ostr, const Type &type)
 
     return ostr;
 }
+
+
+/*
+ * Function:	writeSignature
+ *
+ * Description:	Write a type.  Unlike the stream operator for types, the
+ *		parameter types of a function are written as well.
+ */
+
+void writeSignature(ostream &ostr, const Type &type)
+{
+    if (!type.isFunction() || type.parameters() == nullptr)
+	ostr << type;
+
+    else {
+	ostr << Type(type.specifier(), type.indirection()) << "(";
+
+	if (type.parameters()->empty())
+	    ostr << "void";
+
+	for (unsigned i = 0; i < type.parameters()->size(); i ++)
+	    ostr << (i > 0 ? ", " : "") << type.parameters()->at(i);
+
+	ostr << ")";
+    }
+}
@@ -20,6 +20,15 @@
  *		As we've designed them, types are essentially immutable,
  *		since we haven't included any mutators.  In practice, we'll
  *		be creating new types rather than changing existing types.
+ *
+ *		Since they are immutable, types are interned: a type is just
+ *		a handle, and each distinct type is stored only once, so two
+ *		types are the same exactly when their handles are equal.
+ *		Scalar types and the error type are encoded in the handle
+ *		itself, and array and function types are kept in a table
+ *		shared by all threads.  The table also owns the parameter
+ *		lists, which are shared by every function type with the
+ *		same parameters and are never changed or deleted.
  */
 
 # ifndef TYPE_H
@@ -30,18 +39,15 @@
 typedef std::vector<class Type> Parameters;
 
 class Type {
-    int _specifier;
-    unsigned _indirection;
-    unsigned long _length;
-    Parameters *_parameters;
-
-    enum { ARRAY, ERROR, FUNCTION, SCALAR } _declarator;
+    unsigned _handle;
 
 public:
     Type();
     Type(int specifier, unsigned indirection = 0);
     Type(int specifier, unsigned indirection, unsigned long length);
-    Type(int specifier, unsigned indirection, Parameters *parameters);
+    Type(int specifier, unsigned indirection, const Parameters *parameters);
+
+    static bool valid(int specifier, unsigned indirection);
 
     bool operator ==(const Type &rhs) const;
     bool operator !=(const Type &rhs) const;
@@ -54,7 +60,8 @@ public:
     int specifier() const;
     unsigned indirection() const;
     unsigned long length() const;
-    Parameters *parameters() const;
+    const Parameters *parameters() const;
+    unsigned handle() const;
 
     //is predicate/pointer/numeric
     bool isPredicate() const;
@@ -67,5 +74,6 @@ public:
 };
 
 std::ostream &operator <<(std::ostream &ostr, const Type &type);
+void writeSignature(std::ostream &ostr, const Type &type);
 
 # endif /* TYPE_H */
@@ -0,0 +1,90 @@
+#!/bin/sh
+#
+# File:		bench.sh
+#
+# Description:	Time the compiler on synthetic programs of increasing size.
+#		For each shape of program and each size in lines, we time
+#		only reading the tokens (--lex), only checking the globals
+#		(--skim), checking everything, and checking everything in
+#		parallel.  Times are given in milliseconds and also in
+#		nanoseconds per line, which should stay flat as the size
+#		grows if the compiler scales linearly.
+#
+#		The shapes are "functions", which is mostly function bodies
+#		with a few globals, and "globals", where half of the lines
+#		are global declarations.
+#
+#		Environment variables:
+#		SCC	compiler to time (../scc)
+#		GEN	program generator (./generate)
+#		SIZES	sizes in lines (1000 10000 100000 1000000 10000000)
+#		SHAPES	shapes to run (functions globals)
+#		JOBS	threads for the parallel run (number of processors)
+#		LIMIT	seconds before giving up on a run (300)
+#
+
+SCC=${SCC:-../scc}
+GEN=${GEN:-./generate}
+SIZES=${SIZES:-"1000 10000 100000 1000000 10000000"}
+SHAPES=${SHAPES:-"functions globals"}
+JOBS=${JOBS:-`nproc 2>/dev/null || echo 4`}
+LIMIT=${LIMIT:-300}
+WORKDIR=${TMPDIR:-/tmp}/scc-bench.$$
+
+trap 'rm -rf $WORKDIR' 0 2 15
+mkdir -p $WORKDIR || exit 1
+
+
+# run a mode of the compiler on a file and print its time in milliseconds
+
+run() {
+    file=$1
+    shift
+    start=`date +%s%N`
+    timeout $LIMIT $SCC "$@" < $file > /dev/null 2> $WORKDIR/errors
+    status=$?
+    end=`date +%s%N`
+
+    if [ $status -eq 124 ]; then
+	echo timeout
+    elif [ -s $WORKDIR/errors ]; then
+	echo error
+    else
+	echo $(( (end - start) / 1000000 ))
+    fi
+}
+
+
+# print a time and the time per line
+
+column() {
+    case $1 in
+    [0-9]*) printf " %9s %7s" $1 $(( $1 * 1000000 / $2 )) ;;
+    *) printf " %9s %7s" $1 - ;;
+    esac
+}
+
+
+printf "%-9s %9s %11s %9s %7s %9s %7s %9s %7s %9s %7s\n" shape lines bytes \
+    lex ns/ln skim ns/ln check ns/ln "-j$JOBS" ns/ln
+
+for shape in $SHAPES; do
+    for lines in $SIZES; do
+	case $shape in
+	globals) args="-G $((lines / 2))" ;;
+	*) args="" ;;
+	esac
+
+	file=$WORKDIR/$shape.$lines.c
+	$GEN -l $lines $args > $file || exit 1
+	lines=`wc -l < $file`
+
+	printf "%-9s %9s %11s" $shape $lines `wc -c < $file`
+	column `run $file --lex` $lines
+	column `run $file --skim` $lines
+	column `run $file` $lines
+	column `run $file -j $JOBS` $lines
+	echo
+	rm -f $file
+    done
+done
@@ -0,0 +1,131 @@
+#!/bin/sh
+#
+# File:		counts.sh
+#
+# Description:	Check the compiler for regressions in the work done in each
+#		phase.  We make a fixed set of synthetic programs, whose
+#		text is the same on every system, check each one with
+#		-ftime-report -ftime-counters, and compare the instructions
+#		retired in each phase, and in total, with a baseline.  The
+#		instructions barely change from run to run, unlike times on
+#		a shared machine, so even a small regression shows.
+#
+#		If the system has no hardware counters, we fall back to the
+#		least time of each phase over several runs, which is noisy
+#		and depends on the machine, so it is compared with a larger
+#		threshold.  The baseline records which was measured, and
+#		only the same measure is ever compared.
+#
+#		A phase fails if it grew by more than the threshold, and by
+#		more than a tenth of a percent of the total, so that tiny
+#		phases cannot fail on their own.  The exit status is zero
+#		only if nothing failed.
+#
+#		Environment variables:
+#		SCC		compiler to measure (../scc)
+#		GEN		program generator (./generate)
+#		BASELINE	baseline file (./counts.base)
+#		UPDATE		if set, write the baseline instead
+#		THRESHOLD	percent growth in instructions to fail (2)
+#		SLOWDOWN	percent growth in time to fail (25)
+#		RUNS		runs to take the least time of (5)
+#
+
+SCC=${SCC:-../scc}
+GEN=${GEN:-./generate}
+BASELINE=${BASELINE:-./counts.base}
+THRESHOLD=${THRESHOLD:-2}
+SLOWDOWN=${SLOWDOWN:-25}
+RUNS=${RUNS:-5}
+WORKDIR=${TMPDIR:-/tmp}/scc-counts.$$
+
+CORPORA="
+functions	-l 50000
+globals		-l 50000 -G 25000
+expressions	-l 20000 -d 6
+nesting		-l 20000 -n 5 -g 8
+"
+
+trap 'rm -rf $WORKDIR' 0 2 15
+mkdir -p $WORKDIR || exit 1
+
+
+# measure a program, printing each phase with its instructions, or its least
+# time over the runs if there are no counters
+
+measure() {
+    run=1
+
+    while [ $run -le $RUNS ]; do
+	$SCC -ftime-report -ftime-counters < $1 > /dev/null 2> $WORKDIR/report
+
+	if grep -q '^phase.*instructions' $WORKDIR/report; then
+	    awk '/^phase/ { on = 1; next } /^wall/ { on = 0 }
+		on && $1 != "wait" { print $1, "instructions", $4 }' $WORKDIR/report
+	    break
+	fi
+
+	awk '/^phase/ { on = 1; next } /^wall/ { on = 0 }
+	    on && $1 != "wait" { print $1, "ms", $2 }' $WORKDIR/report
+	run=$((run + 1))
+    done | awk '!($1 in least) || $3 < least[$1] { least[$1] = $3; unit[$1] = $2 }
+	END { for (p in least) print p, unit[p], least[p] }'
+}
+
+
+echo "$CORPORA" | while read name args; do
+    test -z "$name" && continue
+    $GEN $args > $WORKDIR/$name.c || exit 1
+    measure $WORKDIR/$name.c | sed "s/^/$name /"
+done | sort > $WORKDIR/current
+
+if [ ! -s $WORKDIR/current ]; then
+    echo "cannot measure $SCC" 1>&2
+    exit 1
+fi
+
+if [ -n "$UPDATE" ]; then
+    cp $WORKDIR/current $BASELINE || exit 1
+    echo "wrote `awk '{ print $3 }' $WORKDIR/current | sort -u` to $BASELINE"
+    exit 0
+fi
+
+test -r $BASELINE || { echo "cannot read $BASELINE" 1>&2; exit 1; }
+
+awk -v instructions=$THRESHOLD -v ms=$SLOWDOWN '
+    NR == FNR { base[$1 " " $2 " " $3] = $4; next }
+    { key = $1 " " $2 " " $3; now[key] = $4; order[++ n] = key
+      if ($2 == "total") total[$1 " " $3] = $4 }
+    END {
+	printf "%-12s %-7s %-13s %15s %15s %8s\n", "corpus", "phase", "measure",
+	    "baseline", "current", "change"
+	for (i = 1; i <= n; i ++) {
+	    key = order[i]; split(key, f, " ")
+
+	    if (!(key in base)) {
+		printf "%-12s %-7s %-13s %15s %15s %8s   no baseline\n", f[1], f[2], f[3],
+		    "-", now[key], "-"
+		missing ++
+		continue
+	    }
+
+	    delta = now[key] - base[key]
+	    change = base[key] > 0 ? 100 * delta / base[key] : 0
+	    limit = f[3] == "ms" ? ms : instructions
+	    flag = ""
+
+	    if (change > limit && delta > total[f[1] " " f[3]] / 1000) {
+		flag = "   FAILED"
+		failed ++
+	    }
+
+	    printf "%-12s %-7s %-13s %15s %15s %7.2f%%%s\n", f[1], f[2], f[3],
+		base[key], now[key], change, flag
+	}
+
+	if (missing > 0)
+	    print missing " measures have no baseline; set UPDATE to write one"
+
+	print failed + 0 " regressions"
+	exit failed > 0
+    }' $BASELINE $WORKDIR/current
@@ -0,0 +1,387 @@
+/*
+ * File:	generate.cpp
+ *
+ * Description:	This file contains a generator of synthetic Simple C
+ *		programs for benchmarking the compiler.  The programs are
+ *		valid, so checking them reports no errors, and their shape
+ *		is controlled by the options:
+ *
+ *		-l lines	stop after about this many lines (1000)
+ *		-f functions	or after this many functions
+ *		-G globals	number of globals (8)
+ *		-g locals	number of locals in each block (4)
+ *		-d depth	depth of expressions (3)
+ *		-n nesting	depth of nested statements (2)
+ *		-i length	length of identifiers (8)
+ *		-L percent	percentage of leaves that are literals (30)
+ *		-s seed		seed for the random number generator (1)
+ *
+ *		Every variable is an int, a long, an array of ints, or a
+ *		pointer to an int, and every function takes two ints and
+ *		returns an int, so we only need to track which names are in
+ *		scope to keep the program well typed.  A function only
+ *		calls functions defined before it.
+ */
+
+# include <cstdio>
+# include <cstdlib>
+# include <string>
+# include <vector>
+# include <unistd.h>
+
+using namespace std;
+
+struct Names {
+    vector<string> scalars, integers, arrays, pointers;
+};
+
+static unsigned long lines, maxLines = 1000, maxFunctions;
+static unsigned globals = 8, locals = 4, depth = 3, nesting = 2;
+static unsigned length = 8, literals = 30, seed = 1;
+static vector<Names> scopes;
+static vector<string> functions;
+static string out;
+
+
+/*
+ * Function:	choose
+ *
+ * Description:	Return a pseudo-random number less than N.  We use our own
+ *		generator so the output is the same on every system.
+ */
+
+static unsigned choose(unsigned n)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % n;
+}
+
+
+/*
+ * Function:	name
+ *
+ * Description:	Return a name with the given prefix and number, padded with
+ *		zeros to the identifier length.
+ */
+
+static string name(char prefix, unsigned long n)
+{
+    string digits = to_string(n);
+
+    if (digits.size() + 2 < length)
+	digits.insert(0, length - digits.size() - 2, '0');
+
+    return string(1, prefix) + "_" + digits;
+}
+
+
+/*
+ * Function:	emit
+ *
+ * Description:	Write a line with the given indentation, flushing the
+ *		output buffer when it gets large.
+ */
+
+static void emit(unsigned indent, const string &text)
+{
+    out.append(indent, '\t');
+    out += text;
+    out += '\n';
+    lines ++;
+
+    if (out.size() > 1 << 16) {
+	fwrite(out.data(), 1, out.size(), stdout);
+	out.clear();
+    }
+}
+
+
+/*
+ * Function:	pick
+ *
+ * Description:	Return a random name from the given list in any scope, or
+ *		an empty string if there is none.
+ */
+
+static string pick(vector<string> Names::*list)
+{
+    unsigned total = 0, n;
+
+    for (auto &scope : scopes)
+	total += (scope.*list).size();
+
+    if (total == 0)
+	return "";
+
+    n = choose(total);
+
+    for (auto &scope : scopes)
+	if (n < (scope.*list).size())
+	    return (scope.*list)[n];
+	else
+	    n -= (scope.*list).size();
+
+    return "";
+}
+
+
+/*
+ * Function:	expression
+ *
+ * Description:	Return a random numeric expression of at most the given
+ *		depth.
+ */
+
+static string expression(unsigned depth)
+{
+    static const char *binary[] = {
+	"+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=", "&&", "||",
+    };
+
+    string s;
+
+
+    if (depth > 0 && choose(4) != 0) {
+	switch (choose(8)) {
+	case 0:
+	    return "- " + expression(depth - 1);
+
+	case 1:
+	    return "!" + expression(depth - 1);
+
+	case 2:
+	    return "(" + expression(depth - 1) + ")";
+
+	case 3:
+	    if (!functions.empty()) {
+		s = functions[choose(functions.size())];
+		return s + "(" + expression(depth - 1) + ", " + expression(depth - 1) + ")";
+	    }
+
+	    /* fall through */
+
+	default:
+	    s = binary[choose(sizeof(binary) / sizeof(binary[0]))];
+	    return expression(depth - 1) + " " + s + " " + expression(depth - 1);
+	}
+    }
+
+    if (choose(100) < literals) {
+	if (choose(4) == 0)
+	    return string("'") + (char) ('a' + choose(26)) + "'";
+
+	return to_string(choose(1000));
+    }
+
+    switch (choose(6)) {
+    case 0:
+	if (!(s = pick(&Names::arrays)).empty())
+	    return s + "[" + expression(depth > 0 ? depth - 1 : 0) + "]";
+	break;
+
+    case 1:
+	if (!(s = pick(&Names::pointers)).empty())
+	    return "*" + s;
+	break;
+
+    case 2:
+	if (!(s = pick(&Names::scalars)).empty())
+	    return "sizeof " + s;
+	break;
+    }
+
+    if (!(s = pick(&Names::scalars)).empty())
+	return s;
+
+    return to_string(choose(1000));
+}
+
+
+/*
+ * Function:	declare
+ *
+ * Description:	Declare the given number of variables in the innermost
+ *		scope, using the given prefix for their names.
+ */
+
+static void declare(unsigned indent, unsigned count, char prefix, unsigned long &next)
+{
+    string n;
+
+
+    for (unsigned i = 0; i < count; i ++) {
+	n = name(prefix, next ++);
+
+	switch (choose(5)) {
+	case 0:
+	    emit(indent, "long " + n + ";");
+	    scopes.back().scalars.push_back(n);
+	    break;
+
+	case 1:
+	    emit(indent, "int " + n + "[" + to_string(1 + choose(100)) + "];");
+	    scopes.back().arrays.push_back(n);
+	    break;
+
+	case 2:
+	    emit(indent, "int *" + n + ";");
+	    scopes.back().pointers.push_back(n);
+	    break;
+
+	default:
+	    emit(indent, "int " + n + ";");
+	    scopes.back().scalars.push_back(n);
+	    scopes.back().integers.push_back(n);
+	    break;
+	}
+    }
+}
+
+
+/*
+ * Function:	statement
+ *
+ * Description:	Write a random statement with at most the given nesting.
+ */
+
+static void statement(unsigned indent, unsigned nesting, unsigned long &next)
+{
+    string s;
+
+
+    switch (nesting > 0 ? choose(8) : 7) {
+    case 0:
+	emit(indent, "if (" + expression(depth) + ")");
+	statement(indent + 1, nesting - 1, next);
+
+	if (choose(2) == 0) {
+	    emit(indent, "else");
+	    statement(indent + 1, nesting - 1, next);
+	}
+
+	break;
+
+    case 1:
+	emit(indent, "while (" + expression(depth) + ")");
+	statement(indent + 1, nesting - 1, next);
+	break;
+
+    case 2:
+	s = pick(&Names::scalars);
+	emit(indent, "for (" + s + " = 0; " + s + " < " + expression(depth) +
+		"; " + s + " = " + s + " + 1)");
+	statement(indent + 1, nesting - 1, next);
+	break;
+
+    case 3:
+	emit(indent, "{");
+	scopes.push_back(Names());
+	declare(indent + 1, locals, 'v', next);
+
+	for (unsigned i = choose(4) + 1; i > 0; i --)
+	    statement(indent + 1, nesting - 1, next);
+
+	scopes.pop_back();
+	emit(indent, "}");
+	break;
+
+    case 4:
+	if (!(s = pick(&Names::pointers)).empty()) {
+	    emit(indent, s + " = &" + pick(&Names::integers) + ";");
+	    break;
+	}
+
+	/* fall through */
+
+    case 5:
+	if (!(s = pick(&Names::arrays)).empty()) {
+	    emit(indent, s + "[" + expression(0) + "] = " + expression(depth) + ";");
+	    break;
+	}
+
+	/* fall through */
+
+    default:
+	emit(indent, pick(&Names::scalars) + " = " + expression(depth) + ";");
+	break;
+    }
+}
+
+
+/*
+ * Function:	function
+ *
+ * Description:	Write a function definition.  The parameters are always
+ *		scalars, so every statement has something to assign to.
+ */
+
+static void function()
+{
+    unsigned long next = 0;
+    string n, a, b;
+
+
+    n = name('f', functions.size());
+    a = name('q', 0);
+    b = name('q', 1);
+
+    emit(0, "int " + n + "(int " + a + ", int " + b + ")");
+    emit(0, "{");
+
+    scopes.push_back(Names());
+    scopes.back().scalars = scopes.back().integers = {a, b};
+    declare(1, locals, 'v', next);
+
+    for (unsigned i = choose(8) + 2; i > 0; i --)
+	statement(1, nesting, next);
+
+    emit(1, "return " + expression(depth) + ";");
+    scopes.pop_back();
+
+    emit(0, "}");
+    emit(0, "");
+    functions.push_back(n);
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Write a program to the standard output.
+ */
+
+int main(int argc, char *argv[])
+{
+    unsigned long next = 0;
+    int c;
+
+
+    while ((c = getopt(argc, argv, "l:f:G:g:d:n:i:L:s:")) != -1)
+	switch (c) {
+	case 'l': maxLines = strtoul(optarg, NULL, 0); break;
+	case 'f': maxFunctions = strtoul(optarg, NULL, 0); break;
+	case 'G': globals = strtoul(optarg, NULL, 0); break;
+	case 'g': locals = strtoul(optarg, NULL, 0); break;
+	case 'd': depth = strtoul(optarg, NULL, 0); break;
+	case 'n': nesting = strtoul(optarg, NULL, 0); break;
+	case 'i': length = strtoul(optarg, NULL, 0); break;
+	case 'L': literals = strtoul(optarg, NULL, 0); break;
+	case 's': seed = strtoul(optarg, NULL, 0); break;
+
+	default:
+	    fprintf(stderr, "usage: %s [-l lines] [-f functions] [-G globals]"
+		    " [-g locals] [-d depth] [-n nesting] [-i length]"
+		    " [-L percent] [-s seed]\n", argv[0]);
+	    exit(EXIT_FAILURE);
+	}
+
+    scopes.push_back(Names());
+    declare(0, globals, 'g', next);
+    emit(0, "");
+
+    while (maxFunctions ? functions.size() < maxFunctions : lines < maxLines)
+	function();
+
+    fwrite(out.data(), 1, out.size(), stdout);
+    exit(EXIT_SUCCESS);
+}
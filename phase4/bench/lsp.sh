@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# File:		lsp.sh
+#
+# Description:	Time the language server on edits to a synthetic program.
+#		We make a program of the given size, make a session of
+#		edits to it, and replay the session against the compiler
+#		with --lsp, reporting how long each edit takes to get its
+#		diagnostics in milliseconds.  Editing a function body only
+#		checks that body again, while adding a global checks
+#		everything again, so the slowest edits are the globals.
+#		If a recorded session is given, it is replayed instead.
+#
+#		Environment variables:
+#		SCC	compiler to time (../scc)
+#		GEN	program generator (./generate)
+#		REPLAY	session player (./replay)
+#		LINES	size of the program in lines (100000)
+#		EDITS	number of edits (100)
+#		GLOBALS	percentage of edits that add a global (5)
+#		SESSION	recorded session to replay instead (none)
+#
+
+SCC=${SCC:-../scc}
+GEN=${GEN:-./generate}
+REPLAY=${REPLAY:-./replay}
+LINES=${LINES:-100000}
+EDITS=${EDITS:-100}
+GLOBALS=${GLOBALS:-5}
+WORKDIR=${TMPDIR:-/tmp}/scc-lsp.$$
+
+trap 'rm -rf $WORKDIR' 0 2 15
+mkdir -p $WORKDIR || exit 1
+
+if [ -z "$SESSION" ]; then
+    $GEN -l $LINES > $WORKDIR/program.c || exit 1
+    SESSION=$WORKDIR/session
+    $REPLAY -m $WORKDIR/program.c -n $EDITS -G $GLOBALS > $SESSION || exit 1
+    echo "`wc -l < $WORKDIR/program.c` lines, $EDITS edits, $GLOBALS% globals"
+fi
+
+$REPLAY $SESSION $SCC --lsp
@@ -0,0 +1,357 @@
+/*
+ * File:	replay.cpp
+ *
+ * Description:	This file contains a benchmark of the language server in
+ *		Simple C, which replays a recorded session of edits and
+ *		times how long each edit takes to get its diagnostics.  A
+ *		session is the messages sent by an editor, framed just as
+ *		they are sent, which is also what the compiler writes with
+ *		--record.  It has two modes:
+ *
+ *		replay session command [args ...]
+ *			start the command as a server, send it every message
+ *			in the session, and time each document opened or
+ *			changed until its diagnostics are published
+ *
+ *		replay -m source [-n edits] [-G percent] [-s seed]
+ *			make a session that opens the source and then types
+ *			a copy of a statement after a statement chosen at
+ *			random, one character at a time, for each edit; a
+ *			percentage of the edits instead add a global
+ *			declaration at the top of the file
+ *
+ *		Times are in milliseconds, with the median, 90th and 99th
+ *		percentiles, and maximum given for opening and for changing
+ *		the document.
+ */
+
+# include <algorithm>
+# include <chrono>
+# include <cstdio>
+# include <cstdlib>
+# include <cstring>
+# include <fstream>
+# include <sstream>
+# include <string>
+# include <vector>
+# include <sys/wait.h>
+# include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+static const string uri = "file:///replay.c";
+static unsigned edits = 100, globals = 5, seed = 1;
+
+
+/*
+ * Function:	quote
+ *
+ * Description:	Return the given text as a JSON string.
+ */
+
+static string quote(const string &text)
+{
+    string result = "\"";
+    char buf[8];
+
+
+    for (unsigned char c : text)
+	if (c == '"' || c == '\\')
+	    result += '\\', result += c;
+	else if (c == '\n')
+	    result += "\\n";
+	else if (c == '\t')
+	    result += "\\t";
+	else if (c < 0x20) {
+	    snprintf(buf, sizeof(buf), "\\u%04x", c);
+	    result += buf;
+	} else
+	    result += c;
+
+    result += "\"";
+    return result;
+}
+
+
+/*
+ * Function:	frame
+ *
+ * Description:	Write a message to the standard output with its header.
+ */
+
+static void frame(const string &body)
+{
+    printf("Content-Length: %lu\r\n\r\n%s", (unsigned long) body.size(), body.c_str());
+}
+
+
+/*
+ * Function:	change
+ *
+ * Description:	Write a change inserting TEXT at the given line and column.
+ */
+
+static void change(unsigned version, unsigned line, unsigned column, const string &text)
+{
+    string position = "{\"line\":" + to_string(line) + ",\"character\":" + to_string(column) + "}";
+
+
+    frame("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":"
+	    "{\"textDocument\":{\"uri\":\"" + uri + "\",\"version\":" + to_string(version) +
+	    "},\"contentChanges\":[{\"range\":{\"start\":" + position + ",\"end\":" +
+	    position + "},\"text\":" + quote(text) + "}]}}");
+}
+
+
+/*
+ * Function:	make
+ *
+ * Description:	Make a session of edits to the given source.  Only lines
+ *		that are statements, indented and ending with a semicolon,
+ *		are copied, so that the copy is usually a valid statement
+ *		too once it has been typed.
+ */
+
+static int make(const char *path)
+{
+    vector<string> lines;
+    vector<unsigned> statements;
+    unsigned version = 1, line;
+    ifstream in(path);
+    string text;
+
+
+    if (!in) {
+	fprintf(stderr, "replay: cannot open %s\n", path);
+	return EXIT_FAILURE;
+    }
+
+    while (getline(in, text))
+	lines.push_back(text);
+
+    for (unsigned i = 0; i < lines.size(); i ++)
+	if (lines[i].size() > 1 && lines[i][0] == '\t' && lines[i].back() == ';')
+	    statements.push_back(i);
+
+    if (statements.empty()) {
+	fprintf(stderr, "replay: no statements in %s\n", path);
+	return EXIT_FAILURE;
+    }
+
+    text.clear();
+
+    for (auto &l : lines)
+	text += l + "\n";
+
+    srand(seed);
+    frame("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{\"capabilities\":{}}}");
+    frame("{\"jsonrpc\":\"2.0\",\"method\":\"initialized\",\"params\":{}}");
+    frame("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":{\"textDocument\":"
+	    "{\"uri\":\"" + uri + "\",\"languageId\":\"c\",\"version\":1,\"text\":" + quote(text) + "}}}");
+
+    for (unsigned i = 0; i < edits; i ++) {
+	if ((unsigned) rand() % 100 < globals) {
+	    change(++ version, 0, 0, "int replay_" + to_string(i) + ";\n");
+	    lines.insert(lines.begin(), "");
+
+	    for (auto &s : statements)
+		s ++;
+
+	    continue;
+	}
+
+	line = statements[rand() % statements.size()];
+	text = lines[line];
+	change(++ version, line, text.size(), "\n");
+
+	for (unsigned j = 0; j < text.size(); j ++)
+	    change(++ version, line + 1, j, text.substr(j, 1));
+
+	lines.insert(lines.begin() + line + 1, text);
+
+	for (auto &s : statements)
+	    if (s > line)
+		s ++;
+    }
+
+    frame("{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"shutdown\"}");
+    frame("{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}");
+    return EXIT_SUCCESS;
+}
+
+
+/*
+ * Function:	next
+ *
+ * Description:	Read the next framed message from a stream into BODY, and
+ *		return whether there was one.
+ */
+
+static bool next(FILE *fp, string &body)
+{
+    char header[256];
+    long length = -1;
+
+
+    while (fgets(header, sizeof(header), fp) != nullptr) {
+	if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) {
+	    if (length < 0)
+		return false;
+
+	    body.resize(length);
+	    return length == 0 || fread(&body[0], 1, length, fp) == (size_t) length;
+	}
+
+	if (strncasecmp(header, "Content-Length:", 15) == 0)
+	    length = atol(header + 15);
+    }
+
+    return false;
+}
+
+
+/*
+ * Function:	method
+ *
+ * Description:	Return the method named in a message, if any.
+ */
+
+static string method(const string &body)
+{
+    size_t i = body.find("\"method\"");
+
+
+    if (i == string::npos)
+	return "";
+
+    i = body.find('"', body.find(':', i + 8));
+    return i == string::npos ? "" : body.substr(i + 1, body.find('"', i + 1) - i - 1);
+}
+
+
+/*
+ * Function:	report
+ *
+ * Description:	Report the times of one kind of message in milliseconds.
+ */
+
+static void report(const char *kind, vector<double> &times)
+{
+    if (times.empty())
+	return;
+
+    sort(times.begin(), times.end());
+
+    auto at = [&](double p) { return times[min(times.size() - 1, (size_t) (p * times.size()))]; };
+
+    printf("%-8s %7lu %9.3f %9.3f %9.3f %9.3f\n", kind, (unsigned long) times.size(),
+	    at(0.5), at(0.9), at(0.99), times.back());
+}
+
+
+/*
+ * Function:	replay
+ *
+ * Description:	Replay a session against a server started with the given
+ *		command.  A request waits for its response and a document
+ *		opened or changed waits for its diagnostics.
+ */
+
+static int replay(const char *path, char *command[])
+{
+    vector<double> opens, changes;
+    int input[2], output[2], status;
+    string body, name, reply;
+    FILE *session, *to, *from;
+    steady_clock::time_point start;
+    pid_t pid;
+
+
+    if ((session = fopen(path, "rb")) == nullptr) {
+	fprintf(stderr, "replay: cannot open %s\n", path);
+	return EXIT_FAILURE;
+    }
+
+    if (pipe(input) < 0 || pipe(output) < 0 || (pid = fork()) < 0) {
+	perror("replay");
+	return EXIT_FAILURE;
+    }
+
+    if (pid == 0) {
+	dup2(input[0], 0);
+	dup2(output[1], 1);
+	close(input[0]), close(input[1]);
+	close(output[0]), close(output[1]);
+	execvp(command[0], command);
+	perror(command[0]);
+	_exit(127);
+    }
+
+    close(input[0]);
+    close(output[1]);
+    to = fdopen(input[1], "w");
+    from = fdopen(output[0], "r");
+
+    while (next(session, body)) {
+	name = method(body);
+	start = steady_clock::now();
+	fprintf(to, "Content-Length: %lu\r\n\r\n", (unsigned long) body.size());
+	fwrite(body.data(), 1, body.size(), to);
+	fflush(to);
+
+	if (name == "textDocument/didOpen" || name == "textDocument/didChange") {
+	    while (next(from, reply) && method(reply) != "textDocument/publishDiagnostics")
+		continue;
+
+	    double ms = duration<double, milli>(steady_clock::now() - start).count();
+	    (name == "textDocument/didOpen" ? opens : changes).push_back(ms);
+
+	} else if (body.find("\"id\"") != string::npos && name != "exit")
+	    while (next(from, reply) && reply.find("\"id\"") == string::npos)
+		continue;
+    }
+
+    fclose(to);
+    fclose(from);
+    fclose(session);
+    waitpid(pid, &status, 0);
+
+    printf("%-8s %7s %9s %9s %9s %9s\n", "message", "count", "median", "p90", "p99", "max");
+    report("open", opens);
+    report("change", changes);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Make or replay a session.
+ */
+
+int main(int argc, char *argv[])
+{
+    const char *source = nullptr;
+    int c;
+
+
+    while ((c = getopt(argc, argv, "+m:n:G:s:")) != -1)
+	switch (c) {
+	case 'm': source = optarg; break;
+	case 'n': edits = atoi(optarg); break;
+	case 'G': globals = atoi(optarg); break;
+	case 's': seed = atoi(optarg); break;
+	default: argc = 0; break;
+	}
+
+    if (source != nullptr && optind == argc)
+	return make(source);
+
+    if (source == nullptr && argc - optind >= 2)
+	return replay(argv[optind], argv + optind + 1);
+
+    fprintf(stderr, "usage: %s -m source [-n edits] [-G percent] [-s seed]\n", argv[0]);
+    fprintf(stderr, "       %s session command [args ...]\n", argv[0]);
+    return EXIT_FAILURE;
+}
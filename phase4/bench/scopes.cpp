@@ -0,0 +1,124 @@
+/*
+ * File:	scopes.cpp
+ *
+ * Description:	This file contains a benchmark of scopes in Simple C.  For
+ *		scopes of 10, 1K, and 1M symbols, or the sizes given on the
+ *		command line, we time inserting every symbol, finding every
+ *		symbol, failing to find a symbol, and replacing symbols as
+ *		a function definition replaces its declaration.  Small
+ *		scopes are repeated so that each measurement covers a few
+ *		million operations.  Times are in nanoseconds per operation.
+ */
+
+# include <chrono>
+# include <cstdio>
+# include <cstdlib>
+# include <string>
+# include <vector>
+# include "../Scope.h"
+# include "../tokens.h"
+
+using namespace std;
+using namespace std::chrono;
+
+static volatile unsigned long sink;
+
+
+/*
+ * Function:	elapsed
+ *
+ * Description:	Return the nanoseconds per operation since START.
+ */
+
+static double elapsed(steady_clock::time_point start, unsigned long operations)
+{
+    return duration<double, nano>(steady_clock::now() - start).count() / operations;
+}
+
+
+/*
+ * Function:	measure
+ *
+ * Description:	Run the benchmark for scopes of the given size.
+ */
+
+static void measure(unsigned long size)
+{
+    double insert = 0, hit = 0, miss = 0, replace = 0;
+    vector<string> names, missing;
+    vector<Symbol *> symbols;
+    unsigned long rounds;
+    steady_clock::time_point start;
+
+
+    rounds = size < 4000000 ? 4000000 / size : 1;
+
+    for (unsigned long i = 0; i < size; i ++) {
+	names.push_back("symbol_" + to_string(i));
+	missing.push_back("missing_" + to_string(i));
+	symbols.push_back(new Symbol(names.back(), Type(INT)));
+    }
+
+    for (unsigned long r = 0; r < rounds; r ++) {
+	Scope scope;
+
+	start = steady_clock::now();
+
+	for (auto symbol : symbols)
+	    scope.insert(symbol);
+
+	insert += elapsed(start, size);
+	start = steady_clock::now();
+
+	for (auto &name : names)
+	    sink += scope.find(name) != nullptr;
+
+	hit += elapsed(start, size);
+	start = steady_clock::now();
+
+	for (auto &name : missing)
+	    sink += scope.find(name) != nullptr;
+
+	miss += elapsed(start, size);
+	start = steady_clock::now();
+
+	for (unsigned long i = 0; i < size; i += 2) {
+	    scope.remove(names[i]);
+	    scope.insert(symbols[i]);
+	}
+
+	sink += scope.symbols().size();
+	replace += elapsed(start, (size + 1) / 2);
+    }
+
+    printf("%10lu %10.1f %10.1f %10.1f %10.1f\n", size, insert / rounds,
+	    hit / rounds, miss / rounds, replace / rounds);
+
+    for (auto symbol : symbols)
+	delete symbol;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Run the benchmark for each size.
+ */
+
+int main(int argc, char *argv[])
+{
+    printf("%10s %10s %10s %10s %10s\n", "symbols", "insert", "find", "miss",
+	    "replace");
+
+    if (argc > 1)
+	for (int i = 1; i < argc; i ++)
+	    measure(strtoul(argv[i], NULL, 0));
+
+    else {
+	measure(10);
+	measure(1000);
+	measure(1000000);
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,376 @@
+/*
+ * File:	cache.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		caches of results in Simple C.
+ *
+ *		The key of an entry is a 128-bit hash of the source, the
+ *		settings that affect the results, and the identity of the
+ *		compiler, which is the size and time of modification of
+ *		the executable, so that rebuilding the compiler makes every
+ *		old entry miss.  An entry lives in a subdirectory named by
+ *		the first two digits of its key, and is written to a
+ *		temporary file first and then renamed, so that a reader
+ *		sees either all of it or none of it.
+ *
+ *		The counts of hits and misses and the total size of the
+ *		entries are kept in a file of statistics, which is only
+ *		changed while holding a lock on the cache.  Once the total
+ *		size passes the limit, the entries used least recently are
+ *		removed until it is back under nine tenths of the limit.
+ *		Using an entry touches it, so its time of modification is
+ *		when it was last used.
+ */
+
+# include <algorithm>
+# include <cstdint>
+# include <cstdio>
+# include <cstring>
+# include <fstream>
+# include <vector>
+# include <dirent.h>
+# include <fcntl.h>
+# include <sys/file.h>
+# include <sys/stat.h>
+# include <sys/time.h>
+# include <unistd.h>
+# include "cache.h"
+
+using namespace std;
+
+static const char magic[4] = {'S', 'C', 'C', 'R'};
+static const uint32_t version = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    int32_t status;
+    uint32_t unused;
+    uint64_t output, errors;
+};
+
+namespace {
+    struct Victim {
+	time_t used;
+	unsigned long size;
+	string path;
+
+	bool operator <(const Victim &that) const {
+	    return used < that.used;
+	}
+    };
+}
+
+
+/*
+ * Function:	mix
+ *
+ * Description:	Mix a word into a hash, with the given odd multiplier.
+ */
+
+static uint64_t mix(uint64_t hash, uint64_t word, uint64_t multiplier)
+{
+    hash = (hash ^ word) * multiplier;
+    return hash ^ (hash >> 31);
+}
+
+
+/*
+ * Function:	digest
+ *
+ * Description:	Add the given bytes to a pair of hashes, a word at a
+ *		time, followed by their length.
+ */
+
+static void digest(uint64_t hashes[2], const string &bytes)
+{
+    size_t i, n = bytes.size() & ~(size_t) 7;
+    uint64_t word;
+
+
+    for (i = 0; i < n; i += 8) {
+	memcpy(&word, bytes.data() + i, 8);
+	hashes[0] = mix(hashes[0], word, 0x9e3779b97f4a7c15ull);
+	hashes[1] = mix(hashes[1], word, 0xff51afd7ed558ccdull);
+    }
+
+    for (word = 0; i < bytes.size(); i ++)
+	word = word << 8 | (unsigned char) bytes[i];
+
+    hashes[0] = mix(mix(hashes[0], word, 0x9e3779b97f4a7c15ull), bytes.size(), 0xc4ceb9fe1a85ec53ull);
+    hashes[1] = mix(mix(hashes[1], word, 0xff51afd7ed558ccdull), bytes.size(), 0x94d049bb133111ebull);
+}
+
+
+/*
+ * Function:	identity
+ *
+ * Description:	Return the identity of the compiler.
+ */
+
+static string identity()
+{
+    struct stat status;
+    string result = __DATE__ " " __TIME__;
+
+
+    if (stat("/proc/self/exe", &status) == 0) {
+	result += " " + to_string(status.st_size);
+	result += " " + to_string(status.st_mtim.tv_sec);
+	result += "." + to_string(status.st_mtim.tv_nsec);
+    }
+
+    return result;
+}
+
+
+/*
+ * Function:	Cache::Cache (constructor)
+ *
+ * Description:	Initialize this cache to use the given directory, creating
+ *		it if need be, and to hold about as many bytes as the given
+ *		limit.
+ */
+
+Cache::Cache(const string &directory, unsigned long limit)
+    : _directory(directory), _limit(limit), _hits(0), _misses(0), _stored(0)
+{
+    mkdir(_directory.c_str(), 0777);
+}
+
+
+/*
+ * Function:	Cache::key
+ *
+ * Description:	Return the key for the given source checked with the given
+ *		settings, as 32 hexadecimal digits.
+ */
+
+string Cache::key(const string &source, const string &settings)
+{
+    static const string compiler = identity();
+    uint64_t hashes[2] = {0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull};
+    char buf[40];
+
+
+    digest(hashes, source);
+    digest(hashes, settings);
+    digest(hashes, compiler);
+
+    snprintf(buf, sizeof(buf), "%016llx%016llx",
+	    (unsigned long long) hashes[0], (unsigned long long) hashes[1]);
+    return buf;
+}
+
+
+/*
+ * Function:	Cache::path
+ *
+ * Description:	Return the path of the entry with the given key.
+ */
+
+string Cache::path(const string &key) const
+{
+    return _directory + "/" + key.substr(0, 2) + "/" + key.substr(2);
+}
+
+
+/*
+ * Function:	Cache::find
+ *
+ * Description:	Find the entry with the given key, filling it in, and
+ *		return whether it was found.  A damaged entry is a miss.
+ */
+
+bool Cache::find(const string &key, Entry &entry)
+{
+    string name = path(key);
+    ifstream file(name, ios::binary);
+    struct stat status;
+    Header header;
+
+
+    if (file && stat(name.c_str(), &status) == 0 &&
+	    file.read((char *) &header, sizeof(header)) &&
+	    memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+	    header.version == version &&
+	    sizeof(header) + header.output + header.errors == (uint64_t) status.st_size) {
+	entry.status = header.status;
+	entry.output.resize(header.output);
+	entry.errors.resize(header.errors);
+
+	if (file.read(&entry.output[0], header.output) &&
+		file.read(&entry.errors[0], header.errors)) {
+	    utimes(name.c_str(), nullptr);
+	    _hits ++;
+	    return true;
+	}
+    }
+
+    _misses ++;
+    return false;
+}
+
+
+/*
+ * Function:	Cache::store
+ *
+ * Description:	Store an entry with the given key, replacing any entry
+ *		with the same key, such as one just stored by another
+ *		process that missed at the same time.  Failing to store an
+ *		entry is not an error, since it only means a miss the next
+ *		time.
+ */
+
+void Cache::store(const string &key, const Entry &entry)
+{
+    static unsigned count;
+    string name, temporary;
+    struct stat status;
+    long replaced = 0;
+    Header header;
+
+
+    name = path(key);
+    temporary = name.substr(0, name.rfind('/') + 1) + ".tmp." +
+	to_string(getpid()) + "." + to_string(count ++);
+    mkdir(name.substr(0, name.rfind('/')).c_str(), 0777);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.status = entry.status;
+    header.output = entry.output.size();
+    header.errors = entry.errors.size();
+
+    ofstream file(temporary, ios::binary);
+
+    file.write((const char *) &header, sizeof(header));
+    file.write(entry.output.data(), entry.output.size());
+    file.write(entry.errors.data(), entry.errors.size());
+    file.close();
+
+    if (stat(name.c_str(), &status) == 0)
+	replaced = status.st_size;
+
+    if (!file || rename(temporary.c_str(), name.c_str()) != 0) {
+	unlink(temporary.c_str());
+	return;
+    }
+
+    _stored += sizeof(header) + header.output + header.errors - replaced;
+}
+
+
+/*
+ * Function:	evict
+ *
+ * Description:	Remove the entries in a cache directory used least
+ *		recently until they take up no more than the given number
+ *		of bytes, and return how many bytes they take up.  Stray
+ *		temporary files are left alone, since another process may
+ *		still be writing them.
+ */
+
+static unsigned long evict(const string &directory, unsigned long limit)
+{
+    vector<Victim> victims;
+    unsigned long total = 0;
+    struct dirent *item;
+    struct stat status;
+    char sub[3];
+    DIR *dir;
+
+
+    for (unsigned i = 0; i < 256; i ++) {
+	snprintf(sub, sizeof(sub), "%02x", i);
+	string base = directory + "/" + sub + "/";
+
+	if ((dir = opendir(base.c_str())) == nullptr)
+	    continue;
+
+	while ((item = readdir(dir)) != nullptr)
+	    if (item->d_name[0] != '.' &&
+		    stat((base + item->d_name).c_str(), &status) == 0) {
+		victims.push_back(Victim {status.st_mtime,
+			(unsigned long) status.st_size, base + item->d_name});
+		total += status.st_size;
+	    }
+
+	closedir(dir);
+    }
+
+    sort(victims.begin(), victims.end());
+
+    for (unsigned i = 0; i < victims.size() && total > limit; i ++)
+	if (unlink(victims[i].path.c_str()) == 0)
+	    total -= victims[i].size;
+
+    return total;
+}
+
+
+/*
+ * Function:	Cache::update
+ *
+ * Description:	Add the hits, misses, and bytes stored by this process to
+ *		the statistics of the cache, evicting entries if it has
+ *		grown too large, and return whether we could.
+ */
+
+bool Cache::update()
+{
+    unsigned long hits = 0, misses = 0, size = 0;
+    string statistics = _directory + "/stats";
+    int fd;
+
+
+    if ((fd = open((_directory + "/lock").c_str(), O_RDWR | O_CREAT, 0666)) < 0)
+	return false;
+
+    if (flock(fd, LOCK_EX) < 0) {
+	close(fd);
+	return false;
+    }
+
+    ifstream in(statistics);
+    in >> hits >> misses >> size;
+    in.close();
+
+    hits += _hits;
+    misses += _misses;
+    size = (long) size + _stored > 0 ? size + _stored : 0;
+
+    if (size > _limit)
+	size = evict(_directory, _limit / 10 * 9);
+
+    ofstream out(statistics + ".tmp");
+    out << hits << " " << misses << " " << size << "\n";
+    out.close();
+
+    if (out)
+	rename((statistics + ".tmp").c_str(), statistics.c_str());
+
+    _hits = _misses = _stored = 0;
+    close(fd);
+    return bool(out);
+}
+
+
+/*
+ * Function:	Cache::report
+ *
+ * Description:	Write the statistics of the cache as a JSON object.  A
+ *		cache that has never been used has none, so they are zero.
+ */
+
+void Cache::report(ostream &ostr) const
+{
+    unsigned long hits = 0, misses = 0, size = 0;
+    ifstream in(_directory + "/stats");
+
+
+    in >> hits >> misses >> size;
+    ostr << "{\"hits\": " << hits << ", \"misses\": " << misses;
+    ostr << ", \"size\": " << size << ", \"limit\": " << _limit << "}" << endl;
+}
@@ -0,0 +1,45 @@
+/*
+ * File:	cache.h
+ *
+ * Description:	This file contains the class definition for caches of
+ *		results in Simple C.  A cache is a directory of entries,
+ *		each holding the output, rendered diagnostics, and exit
+ *		status of checking a translation unit, named by a key made
+ *		from the source and everything else that affects them.
+ *
+ *		The cache may be shared by several processes at once, so
+ *		an entry is only ever written whole, and the counts and the
+ *		eviction of old entries are done under a lock.
+ */
+
+# ifndef CACHE_H
+# define CACHE_H
+# include <ostream>
+# include <string>
+
+class Cache {
+    typedef std::string string;
+    string _directory;
+    unsigned long _limit;
+    unsigned long _hits, _misses;
+    long _stored;
+
+    string path(const string &key) const;
+
+public:
+    struct Entry {
+	int status;
+	string output, errors;
+    };
+
+    Cache(const string &directory, unsigned long limit);
+
+    static string key(const string &source, const string &settings);
+
+    bool find(const string &key, Entry &entry);
+    void store(const string &key, const Entry &entry);
+    bool update();
+    void report(std::ostream &ostr) const;
+};
+
+# endif /* CACHE_H */
@@ -9,22 +9,91 @@
  *
  *		Extra functionality:
  *		- inserting an undeclared symbol with the error type
+ *		- checking function bodies against a snapshot of the
+ *		  outermost scope, so that they can be checked in parallel
+ *		- folding constant expressions, including sizeof
+ *		- resolving names through a flat symbol table
+ *		- assigning frame slots to locals and parameters
+ *		- counting lookups and the sizes of scopes (stats.h)
+ *		- importing the symbols of a prelude
+ *		- checking a function body again against the same snapshot
+ *		- charging the time spent on scopes and on checking to
+ *		  their own phases (timing.h)
+ *		- tagging the memory of symbols and scopes (stats.h)
+ *		- recording the globals that a function body names, and
+ *		  finding a global as it was at a snapshot, so that the
+ *		  results of checking the body can be kept until one of
+ *		  them changes
+ *
+ *		Every scope still holds its own symbols in order, but names
+ *		in the scopes nested inside the outermost scope are resolved
+ *		using a table of bindings for the thread, so we never walk
+ *		the chain of enclosing scopes.  Globals are then found in
+ *		the outermost scope itself.
+ *
+ *		Each local and parameter is given the next free slot in the
+ *		frame of its function.  A block gives its slots back when
+ *		it is closed, so the blocks of a function that are not
+ *		nested share slots, and the size of the frame is the most
+ *		slots in use at once.
+ *
+ *		Scopes and symbols are allocated in arenas.  The outermost
+ *		scope and the globals live as long as the translation unit,
+ *		while the scopes and symbols of a function are allocated in
+ *		an arena for the thread that is released once the function
+ *		is closed.  Function scopes that are kept for checking later
+ *		are allocated with the globals instead.
+ *
+ *		Each thread has its own outermost scope, so that several
+ *		translation units can be checked at once, one to a thread.
+ *		A thread checking a function body in parallel instead takes
+ *		the outermost scope of the unit from the scope of the body.
+ *
+ *		To take snapshots, we keep every version of each global
+ *		symbol, stamped with the number of changes made to the
+ *		outermost scope so far.  A snapshot is simply a stamp.
+ *		Replaced symbols are never deallocated anyway, since they
+ *		live in the arena for the translation unit.  The versions
+ *		are kept in a history that belongs to the unit, which each
+ *		thread checking its bodies is given, so a thread that isn't
+ *		preserving a unit never sees another's versions.
  */
 
+# include <algorithm>
+# include <climits>
 # include <iostream>
+# include <unordered_map>
 # include "lexer.h"
 # include "checker.h"
+# include "trace.h"
+# include "timing.h"
 # include "tokens.h"
 # include "Symbol.h"
 # include "Scope.h"
 # include "Type.h"
+# include "Layout.h"
+# include "Table.h"
+# include "Arena.h"
+# include "stats.h"
 
 
 using namespace std;
 
-static Scope *outermost, *toplevel;
+static thread_local Scope *outermost;
+static thread_local Scope *toplevel;
+static thread_local Table table;
+static thread_local Arena globalArena;
+static thread_local Arena localArena;
+static thread_local Arena *arena = &globalArena;
+
+static thread_local unsigned slots, frame;
+static thread_local vector<unsigned> marks;
 static const Type error;
 
+static thread_local History *history;
+static thread_local unsigned visible;
+static thread_local Uses *recording;
+
 static string redefined = "redefinition of '%s'";
 static string redeclared = "redeclaration of '%s'";
 static string conflicting = "conflicting types for '%s'";
@@ -41,19 +110,309 @@ static string E6 = "called object is not a function";
 static string E7 = "invalid arguments to called function";
 
 
+/*
+ * Function:	create
+ *
+ * Description:	Create a symbol with the given NAME, TYPE, and SLOT to be
+ *		inserted into SCOPE, in the arena that outlives that scope.
+ */
+
+static Symbol *create(Scope *scope, const string &name, const Type &type,
+	int slot = -1)
+{
+    MemoryTag tag(Memory::SYMBOLS);
+
+
+    if (scope == outermost)
+	return globalArena.make<Symbol>(name, type);
+
+    return arena->make<Symbol>(name, type, slot);
+}
+
+
+/*
+ * Function:	insert
+ *
+ * Description:	Insert SYMBOL into SCOPE, which is either the outermost
+ *		scope or the top-level scope.  In the outermost scope, we
+ *		record a new version if we are preserving it.  Otherwise,
+ *		we bind it in the table.
+ */
+
+static void insert(Scope *scope, Symbol *symbol)
+{
+    MemoryTag tag(Memory::SCOPES);
+
+
+    scope->insert(symbol);
+
+    if (scope != outermost)
+	table.insert(symbol);
+    else if (history != nullptr)
+	history->versions[symbol->name()].push_back(Version(++ history->changes, symbol));
+}
+
+
+/*
+ * Function:	remove
+ *
+ * Description:	Remove the symbol with the given NAME from SCOPE,
+ *		recording its removal if it is the outermost scope and we
+ *		are preserving it.
+ */
+
+static void remove(Scope *scope, const string &name)
+{
+    MemoryTag tag(Memory::SCOPES);
+
+
+    scope->remove(name);
+
+    if (history != nullptr && scope == outermost)
+	history->versions[name].push_back(Version(++ history->changes, nullptr));
+}
+
+
+/*
+ * Function:	find
+ *
+ * Description:	Find the symbol with the given NAME in the top-level scope
+ *		only.
+ */
+
+static Symbol *find(const string &name)
+{
+    return toplevel == outermost ? outermost->find(name) : table.find(name);
+}
+
+
+/*
+ * Function:	lookup
+ *
+ * Description:	Find the nearest symbol with the given NAME starting from
+ *		the top-level scope.  If we are preserving the outermost
+ *		scope, then global symbols are found as they were when this
+ *		thread's snapshot was taken, and every name looked for there
+ *		is recorded if we are recording, whether it was found or
+ *		not.
+ */
+
+static Symbol *lookup(const string &name)
+{
+    Symbol *symbol;
+
+
+    if (stats::enabled) {
+	stats::count(Counter::LOOKUPS);
+	stats::record(Histogram::DEPTH, table.depth(name));
+    }
+
+    if ((symbol = table.lookup(name)) != nullptr)
+	return symbol;
+
+    if (history == nullptr)
+	return outermost->find(name);
+
+    symbol = findGlobal(name, visible);
+
+    if (recording != nullptr)
+	recording->push_back(make_pair(name, symbol));
+
+    return symbol;
+}
+
+
+/*
+ * Function:	findGlobal
+ *
+ * Description:	Find the global symbol with the given NAME as it was at
+ *		SNAPSHOT in the outermost scope, which must be preserved by
+ *		the calling thread.
+ */
+
+Symbol *findGlobal(const string &name, unsigned snapshot)
+{
+    auto it = history->versions.find(name);
+
+    if (it != history->versions.end())
+	for (unsigned i = it->second.size(); i > 0; i --)
+	    if (it->second[i - 1].first <= snapshot)
+		return it->second[i - 1].second;
+
+    return nullptr;
+}
+
+
+/*
+ * Function:	recordUses
+ *
+ * Description:	Start recording the global names looked for by the calling
+ *		thread, with the symbols found, in USES, or stop if it is
+ *		null.
+ */
+
+void recordUses(Uses *uses)
+{
+    recording = uses;
+}
+
+
+/*
+ * Function:	preserveScopes
+ *
+ * Description:	Start preserving the outermost scope of the calling thread
+ *		in HISTORY, so that snapshots of it may be taken, or stop
+ *		if it is null.  This must be done before any globals are
+ *		declared.  A thread checking the function bodies of the
+ *		unit is given the same history, to find its globals.
+ */
+
+void preserveScopes(History *preserved)
+{
+    history = preserved;
+}
+
+
+/*
+ * Function:	snapshotScope
+ *
+ * Description:	Return a snapshot of the outermost scope as it is now.
+ */
+
+unsigned snapshotScope()
+{
+    return history != nullptr ? history->changes : 0;
+}
+
+
+/*
+ * Function:	resumeScope
+ *
+ * Description:	Make SCOPE the top-level scope of the calling thread,
+ *		resolving global symbols as they were at SNAPSHOT in the
+ *		outermost scope that encloses it.  The outermost scope must
+ *		not change while any thread is looking at a snapshot of it.
+ */
+
+void resumeScope(Scope *scope, unsigned snapshot)
+{
+    PhaseTimer timer(Phase::SCOPE);
+    MemoryTag tag(Memory::SCOPES);
+    vector<Scope *> scopes;
+    Scope *s;
+
+
+    for (s = scope; s->enclosing() != nullptr; s = s->enclosing())
+	scopes.push_back(s);
+
+    outermost = s;
+
+    table.clear();
+    marks.clear();
+    slots = 0;
+
+    for (unsigned i = scopes.size(); i > 0; i --) {
+	table.open();
+	marks.push_back(slots);
+
+	for (auto symbol : scopes[i - 1]->symbols()) {
+	    table.insert(symbol);
+
+	    if (symbol->slot() >= (int) slots)
+		slots = symbol->slot() + 1;
+	}
+    }
+
+    frame = slots;
+
+    arena = &localArena;
+    toplevel = scope;
+    visible = snapshot;
+}
+
+
+/*
+ * Function:	reopenScope
+ *
+ * Description:	Resume a copy of SCOPE, which is the scope of a function,
+ *		as with resumeScope.  The copy lives in the arena for the
+ *		thread, so the function can be checked again and again
+ *		while SCOPE itself only ever holds its parameters.
+ */
+
+void reopenScope(Scope *scope, unsigned snapshot)
+{
+    PhaseTimer timer(Phase::SCOPE);
+    MemoryTag tag(Memory::SCOPES);
+    Scope *copy = localArena.make<Scope>(scope->enclosing());
+
+    for (auto symbol : scope->symbols())
+	copy->insert(symbol);
+
+    resumeScope(copy, snapshot);
+}
+
+
+/*
+ * Function:	releaseScopes
+ *
+ * Description:	Release every scope of the calling thread, including the
+ *		outermost scope and its globals, even if some were never
+ *		closed because of a syntax error.  The next scope opened
+ *		starts a new translation unit.  Any versions kept of the
+ *		outermost scope go with it.
+ */
+
+void releaseScopes()
+{
+    PhaseTimer timer(Phase::SCOPE);
+
+
+    if (history != nullptr) {
+	history->versions.clear();
+	history->changes = 0;
+    }
+
+    table.clear();
+    marks.clear();
+    slots = frame = 0;
+
+    localArena.release();
+    globalArena.release();
+    arena = &globalArena;
+    toplevel = outermost = nullptr;
+}
+
+
 /*
  * Function:	openScope
  *
- * Description:	Create a scope and make it the new top-level scope.
+ * Description:	Create a scope and make it the new top-level scope.  The
+ *		scope of a function starts using the arena for the thread,
+ *		unless we are preserving scopes to check the function
+ *		later, in which case it must live as long as the globals.
  */
 
 Scope *openScope()
 {
-    toplevel = new Scope(toplevel);
+    PhaseTimer timer(Phase::SCOPE);
+    MemoryTag tag(Memory::SCOPES);
 
-    if (outermost == nullptr)
-	outermost = toplevel;
 
+    if (outermost == nullptr) {
+	toplevel = outermost = globalArena.make<Scope>();
+	return toplevel;
+    }
+
+    if (toplevel == outermost) {
+	arena = history != nullptr ? &globalArena : &localArena;
+	marks.clear();
+	slots = frame = 0;
+    }
+
+    toplevel = arena->make<Scope>(toplevel);
+    table.open();
+    marks.push_back(slots);
     return toplevel;
 }
 
@@ -62,17 +421,48 @@ Scope *openScope()
  * Function:	closeScope
  *
  * Description:	Remove the top-level scope, and make its enclosing scope
- *		the new top-level scope.
+ *		the new top-level scope.  Closing the scope of a function
+ *		releases the arena for the thread, after which the scope
+ *		returned must not be used unless it was preserved.
  */
 
 Scope *closeScope()
 {
+    PhaseTimer timer(Phase::SCOPE);
     Scope *old = toplevel;
+
+
+    if (stats::enabled)
+	stats::record(Histogram::SYMBOLS, toplevel->symbols().size());
+
+    if (toplevel != outermost) {
+	table.close();
+	slots = marks.back();
+	marks.pop_back();
+    }
+
     toplevel = toplevel->enclosing();
+
+    if (toplevel == outermost && arena == &localArena)
+	localArena.release();
+
     return old;
 }
 
 
+/*
+ * Function:	frameSize
+ *
+ * Description:	Return the number of slots in the frame of the function
+ *		being checked, or last checked, by the calling thread.
+ */
+
+unsigned frameSize()
+{
+    return frame;
+}
+
+
 /*
  * Function:	defineFunction
  *
@@ -84,23 +474,23 @@ Scope *closeScope()
 
 Symbol *defineFunction(const string &name, const Type &type)
 {
-    cout << name << ": " << type << endl;
+    PhaseTimer timer(Phase::SCOPE);
+
+
+    trace::declaration(name, type);
     Symbol *symbol = outermost->find(name);
 
     if (symbol != nullptr) {
-	if (symbol->type().isFunction() && symbol->type().parameters()) {
+	if (symbol->type().isFunction() && symbol->type().parameters())
 	    report(redefined, name);
-	    delete symbol->type().parameters();
-
-	} else if (type != symbol->type())
+	else if (type != symbol->type())
 	    report(conflicting, name);
 
-	outermost->remove(name);
-	delete symbol;
+	remove(outermost, name);
     }
 
-    symbol = new Symbol(name, type);
-    outermost->insert(symbol);
+    symbol = create(outermost, name, type);
+    insert(outermost, symbol);
     return symbol;
 }
 
@@ -115,19 +505,18 @@ Symbol *defineFunction(const string &name, const Type &type)
 
 Symbol *declareFunction(const string &name, const Type &type)
 {
-    cout << name << ": " << type << endl;
+    PhaseTimer timer(Phase::SCOPE);
+
+
+    trace::declaration(name, type);
     Symbol *symbol = outermost->find(name);
 
     if (symbol == nullptr) {
-	symbol = new Symbol(name, type);
-	outermost->insert(symbol);
+	symbol = create(outermost, name, type);
+	insert(outermost, symbol);
 
-    } else if (type != symbol->type()) {
+    } else if (type != symbol->type())
 	report(conflicting, name);
-	delete type.parameters();
-
-    } else
-	delete type.parameters();
 
     return symbol;
 }
@@ -142,15 +531,23 @@ Symbol *declareFunction(const string &name, const Type &type)
 
 Symbol *declareVariable(const string &name, const Type &type)
 {
-    cout << name << ": " << type << endl;
-    Symbol *symbol = toplevel->find(name);
+    PhaseTimer timer(Phase::SCOPE);
+
+
+    trace::declaration(name, type);
+    Symbol *symbol = find(name);
 
     if (symbol == nullptr) {
 	if (type.specifier() == VOID && type.indirection() == 0)
 	    report(void_object, name);
 
-	symbol = new Symbol(name, type);
-	toplevel->insert(symbol);
+	if (toplevel != outermost) {
+	    symbol = create(toplevel, name, type, slots ++);
+	    frame = max(frame, slots);
+	} else
+	    symbol = create(toplevel, name, type);
+
+	insert(toplevel, symbol);
 
     } else if (outermost != toplevel)
 	report(redeclared, name);
@@ -162,6 +559,29 @@ Symbol *declareVariable(const string &name, const Type &type)
 }
 
 
+/*
+ * Function:	importSymbol
+ *
+ * Description:	Declare a symbol with the specified NAME and TYPE in the
+ *		outermost scope without checking it, since it was checked
+ *		when the prelude it comes from was written.  A symbol that
+ *		is already declared is kept.
+ */
+
+Symbol *importSymbol(const string &name, const Type &type)
+{
+    PhaseTimer timer(Phase::SCOPE);
+    Symbol *symbol = outermost->find(name);
+
+    if (symbol == nullptr) {
+	symbol = create(outermost, name, type);
+	insert(outermost, symbol);
+    }
+
+    return symbol;
+}
+
+
 /*
  * Function:	checkIdentifier
  *
@@ -172,322 +592,851 @@ Symbol *declareVariable(const string &name, const Type &type)
 
 Symbol *checkIdentifier(const string &name)
 {
-    Symbol *symbol = toplevel->lookup(name);
+    PhaseTimer timer(Phase::SCOPE);
+    Symbol *symbol = lookup(name);
 
     if (symbol == nullptr) {
+	stats::count(Counter::UNDECLARED);
 	report(undeclared, name);
-	symbol = new Symbol(name, error);
-	toplevel->insert(symbol);
+	symbol = create(toplevel, name, error);
+	insert(toplevel, symbol);
     }
 
     return symbol;
 }
 
-/**
- * Function: checkLogical
- * 
- * Description: Can be used for || or &&, passed operator
- *      makes sure both left and right side of expression
- *      are predicates, returning result Type int
- *      else throwing error invalid operands to binary operator
-*/
-Type checkLogical(const Type &left, const Type &right, const string &op) {
-    if(left == error || right == error) {
-        return error;
-    }
-    Type left_promoted = left.promote();
-    Type right_promoted = right.promote();
-    if(left_promoted.isPredicate() && right_promoted.isPredicate()) {
-        return Type(INT);
-    }
-    else {
-        report(E4, op);
-        return error;
-    }
-}
+/*
+ * Operands are typed using tables rather than by promoting them and
+ * testing the results.  Each type is reduced to a class, which is all
+ * the rules ever look at, and each operator has a table indexed by the
+ * classes of its operands that gives the rule for its result.  The
+ * tables are built at compile time from the rules below, which are
+ * written in terms of the classes of the promoted operands.
+ *
+ * Note that promoting any pointer to char yields int, and that only
+ * one promotion is done at a time, so an array of char is promoted to
+ * a pointer to char, and only then to int.
+ */
 
-/**
- * Function: checkPrefix
- * 
- * Description: Checks prefix operators 
-*/
-Type checkNot(const Type &right) {
-    if(right == error) {
-        return error;
-    }
-    if(right.isPredicate()) {
-        return Type(INT);
-    }
-    report(E5, "!");
-    return error;
+enum {
+    C_ERROR, C_CHAR, C_INT, C_LONG, C_VOID, C_CHARPTR, C_VOIDPTR,
+    C_POINTER, C_CHARARRAY, C_VOIDARRAY, C_ARRAY, C_FUNCTION, CLASSES
+};
 
-    
-    
-}
+typedef unsigned char Rule;
 
-Type checkIf(const Type &left) {
-    if(left == error) {
-        return error;
-    }
-    if(left.isPredicate()) {
-        return left;
-    }
-    report(E2);
-    return error;
-}
+enum {
+    INVALID, SILENT, INTEGER, LONGER, SELF, LEFT, RIGHT, DEREF, SAME = 0x10
+};
 
-Type checkFor(const Type &left) {
-    if(left == error) {
-        return error;
-    }
-    if(left.isPredicate()) {
-        return left;
-    }
-    report(E2);
-    return error;
-}
+static constexpr unsigned promoted[CLASSES] = {
+    C_ERROR, C_INT, C_INT, C_LONG, C_VOID, C_INT, C_VOIDPTR,
+    C_POINTER, C_CHARPTR, C_VOIDPTR, C_POINTER, C_FUNCTION,
+};
 
-Type checkWhile(const Type &left) {
-    if(left == error) {
-        return error;
-    }
-    if(left.isPredicate()) {
-        return left;
-    }
-    report(E2);
-    return error;
-}
+static constexpr bool numeric[CLASSES] = {
+    false, true, true, true, false, false, false,
+    false, false, false, false, false,
+};
 
-Type checkReturn(const Type &func, const Type &right) {
-    if(func == error || right == error) {
-        return error;
-    }
-    if(right.isCompatibleWith(func)) {
-        return right;
-    }
-    report(E1);
-    return error;
-}
+static constexpr bool pointer[CLASSES] = {
+    false, false, false, false, false, true, true,
+    true, true, true, true, false,
+};
 
-Type checkMultiplicative(const Type &left, const Type &right, const string &op) {
-    if(left == error || right == error) {
-        return error;
-    }
-    if(left.isNumeric() && right.isNumeric()) {
-        if(left.specifier() == LONG || right.specifier() == LONG){
-            return Type(LONG);
-        }
-        else {
-            return Type(INT);
-        }
-    }
-    report(E4, op);
-    return error;
-}
 
-Type checkNeg(const Type &right) {
-    if(right == error) {
-        return error;
-    }
-    Type right_promoted = right.promote();
-    if(right_promoted.isNumeric()) {
-        return right_promoted;
-    }
-    report(E5, "-");
-    return error;
-}
+/*
+ * Function:	classify
+ *
+ * Description:	Return the class of TYPE.
+ */
 
-Type checkRelational(const Type &left, const Type &right, const string &op) {
-    if(left == error || right == error) {
-        return error;
-    }
-    Type left_promoted = left.promote();
-    Type right_promoted = right.promote();
-    if(left_promoted.isNumeric() && right_promoted.isNumeric()) {
-        return Type(INT);
-    }
-    if(left_promoted.isPredicate() && left_promoted == right_promoted) {
-        return Type(INT);
-    }
-    // if(left_promoted == right_promoted && (left_promoted.isNumeric() || left_promoted.isPointer())) {
-    //     return Type(INT);
-    // }
-    report(E4, op);
-    return error;
-}
+static unsigned classify(const Type &type)
+{
+    int specifier;
+    unsigned indirection;
 
-Type checkEquality(const Type& left, const Type &right, const string &op) {
-    if(left == error || right == error) {
-        return error;
-    }
-    Type left_promoted = left.promote();
-    Type right_promoted = right.promote();
-    if(left_promoted.isCompatibleWith(right_promoted)) {
-        return Type(INT);
-    }
-    report(E4, op);
-    return error;
-}
 
-Type checkSub(const Type &left, const Type &right) {
-    if(left == error || right == error) {
-        return error;
-    }
-    Type left_promoted = left.promote();
-    Type right_promoted = right.promote();
-    if(left_promoted.isNumeric() && right_promoted.isNumeric()) {
-        if(left_promoted.specifier() == LONG || right_promoted.specifier() == LONG) {
-            return Type(LONG);
-        }
-        else {
-            return Type(INT);
-        }
-    }
-    if(left_promoted.isPointer() && right_promoted.isNumeric()) {
-        if(left_promoted != Type(VOID, 1)){
-            return Type(left_promoted.specifier(), left_promoted.indirection());
-        } 
-    }
-    if(left_promoted.isPointer() && right_promoted.isPointer()) {
-        if(left_promoted.isCompatibleWith(right) && left_promoted != Type(VOID, 1)) {
-            return Type(LONG);
-        }
-    }
-    report(E4, "-");
-    return error;
+    if (type.isError())
+	return C_ERROR;
 
-}
+    if (type.isFunction())
+	return C_FUNCTION;
 
-Type checkAdd(const Type &left, const Type &right) {
-    if(left == error || right == error) {
-        return error;
-    }
-    Type left_promoted = left.promote();
-    Type right_promoted = right.promote();
-    if(left_promoted.isNumeric() && right_promoted.isNumeric()) {
-        if(left_promoted.specifier() == LONG || right_promoted.specifier() == LONG) {
-            return Type(LONG);
-        }
-        else {
-            return Type(INT);
-        }
-    }
-    if(left_promoted.isPointer() && right_promoted.isNumeric()) {
-        if(left_promoted != Type(VOID, 1)) {
-            return Type(left_promoted.specifier(), left_promoted.indirection());
-        } 
-    }
-    if(left_promoted.isNumeric() && right_promoted.isPointer()) {
-        if(right_promoted != Type(VOID, 1)) {
-            return Type(right_promoted.specifier(), right_promoted.indirection());
-        }
-    }
-    report(E4, "-");
-    return error;
-}
+    specifier = type.specifier();
+    indirection = type.indirection();
 
-Type checkDeref(const Type &right) {
-    if(right == error) {
-        return error;
-    }
-    Type right_promoted = right.promote();
-    if(right_promoted.isPointer() && right_promoted != Type(VOID, 1)) {
-        return Type(right_promoted.specifier(), right_promoted.indirection() - 1);
+    if (type.isArray()) {
+	if (specifier == CHAR)
+	    return C_CHARARRAY;
+
+	return specifier == VOID && indirection == 0 ? C_VOIDARRAY : C_ARRAY;
     }
-    report(E5, "*");
-    return error;
 
-}
+    if (indirection == 0) {
+	if (specifier == CHAR)
+	    return C_CHAR;
 
-Type checkPost(const Type &left, const Type &right) {
-    if(left == error || right == error) {
-        return error;
-    }
-    Type left_promoted = left.promote();
-    Type right_promoted = right.promote();
-    if(left_promoted.isPointer() && left_promoted != Type(VOID, 1) && right_promoted.isNumeric()) {
-        return Type(left_promoted.specifier(), left_promoted.indirection() - 1);
-    }
-    report(E4, "[]");
-    return error;
-}
+	if (specifier == LONG)
+	    return C_LONG;
 
-Type checkAddr(const Type &right, const bool &lvalue) {
-    if(right == error) {
-        return error;
+	return specifier == VOID ? C_VOID : C_INT;
     }
-    if(lvalue) {
-        return Type(right.specifier(), right.indirection() + 1);
-    }
-    report(E3);
-    return error;
+
+    if (specifier == CHAR)
+	return C_CHARPTR;
+
+    return specifier == VOID && indirection == 1 ? C_VOIDPTR : C_POINTER;
 }
 
-Type checkSizeof(const Type &right) {
-    if(right == error) {
-        return error;
-    }
-    if(right.isPredicate() && !right.isFunction()) {
-        return Type(LONG);
+
+/*
+ * Function:	decayed
+ *
+ * Description:	Return TYPE with an array converted to a pointer.  This is
+ *		what promoting any pointer or array yields, as long as the
+ *		result is not a pointer to char.
+ */
+
+static Type decayed(const Type &type)
+{
+    if (type.isArray())
+	return Type(type.specifier(), type.indirection() + 1);
+
+    return type;
+}
+
+
+/*
+ * Function:	predicate
+ *
+ * Description:	Return whether a class is a predicate type.
+ */
+
+static constexpr bool predicate(unsigned c)
+{
+    return numeric[c] || pointer[c];
+}
+
+
+/*
+ * Function:	widest
+ *
+ * Description:	Return the rule for the result of an arithmetic operator
+ *		on numeric classes.
+ */
+
+static constexpr Rule widest(unsigned l, unsigned r)
+{
+    return l == C_LONG || r == C_LONG ? LONGER : INTEGER;
+}
+
+
+/*
+ * Function:	retype
+ *
+ * Description:	Change the result of a valid rule, keeping its condition.
+ */
+
+static constexpr Rule retype(Rule rule, Rule result)
+{
+    return rule == INVALID ? INVALID : (rule & SAME) | result;
+}
+
+
+/*
+ * Function:	compatible
+ *
+ * Description:	Return the rule for whether the classes are compatible
+ *		after promotion.  Two pointers are compatible if they are
+ *		the same type, which depends on more than their classes.
+ */
+
+static constexpr Rule compatible(unsigned a, unsigned b)
+{
+    return numeric[promoted[a]] && numeric[promoted[b]] ? INTEGER :
+	pointer[promoted[a]] && promoted[a] == promoted[b] ?
+	    (promoted[a] == C_VOIDPTR ? INTEGER : SAME | INTEGER) :
+	pointer[promoted[a]] && promoted[b] == C_VOIDPTR ? INTEGER :
+	promoted[a] == C_VOIDPTR && pointer[promoted[b]] ? INTEGER : INVALID;
+}
+
+
+/*
+ * Function:	silent
+ *
+ * Description:	Return whether either class is the error class, in which
+ *		case an error has already been reported.
+ */
+
+static constexpr bool silent(unsigned l, unsigned r)
+{
+    return l == C_ERROR || r == C_ERROR;
+}
+
+
+/*
+ * These are the rules for each operator.  A binary rule is given the
+ * classes of the left and right operands and a unary rule is given the
+ * class of its operand.
+ */
+
+static constexpr Rule logical(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT :
+	predicate(promoted[l]) && predicate(promoted[r]) ? INTEGER : INVALID;
+}
+
+static constexpr Rule multiplicative(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT :
+	numeric[l] && numeric[r] ? widest(l, r) : INVALID;
+}
+
+static constexpr Rule relational(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT :
+	numeric[promoted[l]] && numeric[promoted[r]] ? INTEGER :
+	pointer[promoted[l]] && promoted[l] == promoted[r] ?
+	    (promoted[l] == C_VOIDPTR ? INTEGER : SAME | INTEGER) : INVALID;
+}
+
+static constexpr Rule equality(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT : compatible(promoted[l], promoted[r]);
+}
+
+static constexpr Rule additive(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT :
+	numeric[promoted[l]] && numeric[promoted[r]] ?
+	    widest(promoted[l], promoted[r]) :
+	pointer[promoted[l]] && numeric[promoted[r]] ?
+	    (promoted[l] != C_VOIDPTR ? LEFT : INVALID) :
+	numeric[promoted[l]] && pointer[promoted[r]] ?
+	    (promoted[r] != C_VOIDPTR ? RIGHT : INVALID) : INVALID;
+}
+
+static constexpr Rule subtractive(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT :
+	numeric[promoted[l]] && numeric[promoted[r]] ?
+	    widest(promoted[l], promoted[r]) :
+	promoted[l] == C_VOIDPTR ? INVALID :
+	pointer[promoted[l]] && numeric[promoted[r]] ? LEFT :
+	pointer[promoted[l]] && pointer[promoted[r]] ?
+	    retype(compatible(promoted[l], r), LONGER) : INVALID;
+}
+
+static constexpr Rule indexing(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT :
+	pointer[promoted[l]] && promoted[l] != C_VOIDPTR &&
+	    numeric[promoted[r]] ? DEREF : INVALID;
+}
+
+static constexpr Rule assignment(unsigned l, unsigned r)
+{
+    return silent(l, r) ? SILENT : retype(compatible(l, r), SELF);
+}
+
+static constexpr Rule negation(unsigned c)
+{
+    return c == C_ERROR ? SILENT : predicate(c) ? INTEGER : INVALID;
+}
+
+static constexpr Rule negative(unsigned c)
+{
+    return c == C_ERROR ? SILENT :
+	numeric[promoted[c]] ? widest(promoted[c], promoted[c]) : INVALID;
+}
+
+static constexpr Rule dereference(unsigned c)
+{
+    return c == C_ERROR ? SILENT :
+	pointer[promoted[c]] && promoted[c] != C_VOIDPTR ? DEREF : INVALID;
+}
+
+static constexpr Rule test(unsigned c)
+{
+    return c == C_ERROR ? SILENT : predicate(c) ? SELF : INVALID;
+}
+
+static constexpr Rule size(unsigned c)
+{
+    return c == C_ERROR ? SILENT :
+	predicate(c) && c != C_FUNCTION ? LONGER : INVALID;
+}
+
+static constexpr Rule argument(unsigned c)
+{
+    return predicate(promoted[c]) ? SELF : INVALID;
+}
+
+# define UNARY(f) {f(0), f(1), f(2), f(3), f(4), f(5), f(6), f(7), f(8), \
+		   f(9), f(10), f(11)}
+
+# define ROW(f, l) {f(l, 0), f(l, 1), f(l, 2), f(l, 3), f(l, 4), f(l, 5), \
+		    f(l, 6), f(l, 7), f(l, 8), f(l, 9), f(l, 10), f(l, 11)}
+
+# define BINARY(f) {ROW(f, 0), ROW(f, 1), ROW(f, 2), ROW(f, 3), ROW(f, 4), \
+		    ROW(f, 5), ROW(f, 6), ROW(f, 7), ROW(f, 8), ROW(f, 9), \
+		    ROW(f, 10), ROW(f, 11)}
+
+static_assert(CLASSES == 12, "the tables must cover every class");
+
+static constexpr Rule logicals[CLASSES][CLASSES] = BINARY(logical);
+static constexpr Rule multiplicatives[CLASSES][CLASSES] = BINARY(multiplicative);
+static constexpr Rule relationals[CLASSES][CLASSES] = BINARY(relational);
+static constexpr Rule equalities[CLASSES][CLASSES] = BINARY(equality);
+static constexpr Rule additives[CLASSES][CLASSES] = BINARY(additive);
+static constexpr Rule subtractives[CLASSES][CLASSES] = BINARY(subtractive);
+static constexpr Rule indexings[CLASSES][CLASSES] = BINARY(indexing);
+static constexpr Rule assignments[CLASSES][CLASSES] = BINARY(assignment);
+
+static constexpr Rule negations[CLASSES] = UNARY(negation);
+static constexpr Rule negatives[CLASSES] = UNARY(negative);
+static constexpr Rule dereferences[CLASSES] = UNARY(dereference);
+static constexpr Rule tests[CLASSES] = UNARY(test);
+static constexpr Rule sizes[CLASSES] = UNARY(size);
+static constexpr Rule arguments[CLASSES] = UNARY(argument);
+
+
+/*
+ * Function:	apply
+ *
+ * Description:	Return the result of applying RULE to the operands LEFT
+ *		and RIGHT, reporting the given error if the rule or its
+ *		condition fails.  A unary operand is passed as both.
+ */
+
+static Type apply(Rule rule, const Type &left, const Type &right,
+	const string &message, const string &op = "")
+{
+    if (rule & SAME)
+	rule = decayed(left) == decayed(right) ? rule & ~SAME : INVALID;
+
+    switch (rule) {
+    case INTEGER:
+	return Type(INT);
+
+    case LONGER:
+	return Type(LONG);
+
+    case SELF:
+	return left;
+
+    case LEFT:
+	return decayed(left);
+
+    case RIGHT:
+	return decayed(right);
+
+    case DEREF:
+	return Type(left.specifier(), decayed(left).indirection() - 1);
+
+    case INVALID:
+	report(message, op);
+	break;
     }
-    report(E5, "sizeof");
+
     return error;
 }
 
 
-Type checkFunction(const Type &left, Parameters *params) {
-    if(left == error) {
-        return error;
-    }
-    //left not a function
-    if(!left.isFunction()) {
-        report(E6);
-        return error;
-    }
-    for(unsigned i = 0; i < params->size(); ++i) {
-        Type arg_promoted = params->at(i).promote();
-        if(!arg_promoted.isPredicate()) {
-            report(E7);
-            return error;
-        }
+/*
+ * Function:	binary
+ *
+ * Description:	Return the result of a binary operator with the given
+ *		TABLE of rules.
+ */
 
+static Type binary(const Rule table[][CLASSES], const Type &left,
+	const Type &right, const string &message, const string &op = "")
+{
+    Rule rule = table[classify(left)][classify(right)];
+    return apply(rule, left, right, message, op);
+}
+
+
+/*
+ * Function:	unary
+ *
+ * Description:	Return the result of a unary operator with the given TABLE
+ *		of rules.
+ */
+
+static Type unary(const Rule table[], const Type &right, const string &message,
+	const string &op = "")
+{
+    return apply(table[classify(right)], right, right, message, op);
+}
+
+/*
+ * Function:	checkLogical
+ *
+ * Description:	Check a logical operator, || or &&, whose operands must
+ *		be predicates.  The result is an int.
+ */
+
+Type checkLogical(const Type &left, const Type &right, const string &op)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(logicals, left, right, E4, op);
+}
+
+
+/*
+ * Function:	checkNot
+ *
+ * Description:	Check the ! operator, whose operand must be a predicate.
+ */
+
+Type checkNot(const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return unary(negations, right, E5, "!");
+}
+
+
+/*
+ * Function:	checkIf
+ *
+ * Description:	Check the test expression of an if statement.
+ */
+
+Type checkIf(const Type &left)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return unary(tests, left, E2);
+}
+
+
+/*
+ * Function:	checkFor
+ *
+ * Description:	Check the test expression of a for statement.
+ */
+
+Type checkFor(const Type &left)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return unary(tests, left, E2);
+}
+
+
+/*
+ * Function:	checkWhile
+ *
+ * Description:	Check the test expression of a while statement.
+ */
+
+Type checkWhile(const Type &left)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return unary(tests, left, E2);
+}
+
+
+/*
+ * Function:	checkReturn
+ *
+ * Description:	Check that the returned expression is compatible with the
+ *		return type of the function.
+ */
+
+Type checkReturn(const Type &func, const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(assignments, right, func, E1);
+}
+
+
+/*
+ * Function:	checkMultiplicative
+ *
+ * Description:	Check *, /, or %, whose operands must be numeric.  The
+ *		operands are not promoted.
+ */
+
+Type checkMultiplicative(const Type &left, const Type &right, const string &op)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(multiplicatives, left, right, E4, op);
+}
+
+
+/*
+ * Function:	checkNeg
+ *
+ * Description:	Check the unary - operator, whose operand must be numeric.
+ */
+
+Type checkNeg(const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return unary(negatives, right, E5, "-");
+}
+
+
+/*
+ * Function:	checkRelational
+ *
+ * Description:	Check a relational operator, whose operands must both be
+ *		numeric or be the same pointer type.
+ */
+
+Type checkRelational(const Type &left, const Type &right, const string &op)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(relationals, left, right, E4, op);
+}
+
+
+/*
+ * Function:	checkEquality
+ *
+ * Description:	Check == or !=, whose operands must be compatible.
+ */
+
+Type checkEquality(const Type &left, const Type &right, const string &op)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(equalities, left, right, E4, op);
+}
+
+
+/*
+ * Function:	checkSub
+ *
+ * Description:	Check binary -, which allows numbers, a pointer minus a
+ *		number, and the difference of compatible pointers.
+ */
+
+Type checkSub(const Type &left, const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(subtractives, left, right, E4, "-");
+}
+
+
+/*
+ * Function:	checkAdd
+ *
+ * Description:	Check binary +, which allows numbers and a pointer plus a
+ *		number in either order.  An error names the operator as
+ *		'-', not '+', which is wrong but deliberate: it is what the
+ *		reference compiler reports, and our diagnostics must match
+ *		its output exactly.
+ */
+
+Type checkAdd(const Type &left, const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(additives, left, right, E4, "-");
+}
+
+
+/*
+ * Function:	checkDeref
+ *
+ * Description:	Check the unary * operator, whose operand must be a pointer
+ *		other than a pointer to void.
+ */
+
+Type checkDeref(const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return unary(dereferences, right, E5, "*");
+}
+
+
+/*
+ * Function:	checkPost
+ *
+ * Description:	Check an index expression, whose left operand must be a
+ *		pointer other than a pointer to void and whose right operand
+ *		must be numeric.
+ */
+
+Type checkPost(const Type &left, const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return binary(indexings, left, right, E4, "[]");
+}
+
+
+/*
+ * Function:	checkAddr
+ *
+ * Description:	Check the unary & operator, whose operand must be an
+ *		lvalue.
+ */
+
+Type checkAddr(const Type &right, const bool &lvalue)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    if (right == error)
+	return error;
+
+    if (lvalue)
+	return Type(right.specifier(), right.indirection() + 1);
+
+    report(E3);
+    return error;
+}
+
+
+/*
+ * Function:	checkSizeof
+ *
+ * Description:	Check the sizeof operator, whose operand must be a
+ *		predicate.  The result is a long.
+ */
+
+Type checkSizeof(const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    return unary(sizes, right, E5, "sizeof");
+}
+
+
+/*
+ * Function:	checkFunction
+ *
+ * Description:	Check a call of LEFT with the given arguments.  Every
+ *		argument must be a predicate, and if the parameters are
+ *		specified, there must be as many arguments as parameters
+ *		and each must be compatible with its parameter.
+ */
+
+Type checkFunction(const Type &left, const Parameters *params)
+{
+    PhaseTimer timer(Phase::CHECK);
+    const Parameters *parameters;
+
+
+    if (left == error)
+	return error;
+
+    if (!left.isFunction()) {
+	report(E6);
+	return error;
     }
-    //function declared but not defined, no parameters
-    if(left.parameters() == nullptr) {
-        return Type(left.specifier(), left.indirection());
-    }
-    //function declared/defined with parameters
-    if(left.parameters()->size() != params->size()) {
-        report(E7);
-        return error;
-    }
 
-    for(unsigned i = 0; i < params->size(); ++i) {
-        Type param_promoted = left.parameters()->at(i).promote();
-        Type arg_promoted = params->at(i).promote();
-        if(!(param_promoted.isCompatibleWith(arg_promoted))) {
-            report(E7);
-            return error;
-        }
-        // if(!arg_promoted.isPredicate()) {
-        //     report(E7);
-        //     return error;
-        // }
+    for (auto &arg : *params)
+	if (arguments[classify(arg)] == INVALID) {
+	    report(E7);
+	    return error;
+	}
+
+    parameters = left.parameters();
+
+    if (parameters != nullptr) {
+	if (parameters->size() != params->size()) {
+	    report(E7);
+	    return error;
+	}
+
+	for (unsigned i = 0; i < params->size(); i ++) {
+	    const Type &parameter = (*parameters)[i], &arg = (*params)[i];
+
+	    if (apply(equalities[classify(parameter)][classify(arg)],
+		    parameter, arg, E7) == error)
+		return error;
+	}
     }
+
     return Type(left.specifier(), left.indirection());
 }
 
-Type checkAssignment(const Type &left, const Type &right, const bool &lvalue) {
-    if(left == error || right == error) {
-        return error;
-    }
-    else if(!lvalue) {
-        report(E3);
-        return error;
+
+/*
+ * Function:	checkAssignment
+ *
+ * Description:	Check an assignment, whose left operand must be an lvalue
+ *		compatible with the right operand.
+ */
+
+Type checkAssignment(const Type &left, const Type &right, const bool &lvalue)
+{
+    PhaseTimer timer(Phase::CHECK);
+    Rule rule = assignments[classify(left)][classify(right)];
+
+    if (rule == SILENT)
+	return error;
+
+    if (!lvalue) {
+	report(E3);
+	return error;
     }
-    else if(left.isCompatibleWith(right)) {
-        return left;
+
+    return apply(rule, left, right, E4, "=");
+}
+
+
+/*
+ * Function:	foldBinary
+ *
+ * Description:	Return the value of a binary expression with the given
+ *		RESULT type, whose operands have the values LEFT and RIGHT.
+ *		As in C, the operands have already been converted to the
+ *		result type, which must be able to hold the exact result.
+ *		If it can't, or if we'd divide by zero, the behavior is
+ *		undefined and we leave it to run time.  Logical operators
+ *		are known if their left operand decides the result.
+ */
+
+Constant foldBinary(const Type &result, const Constant &left, const Constant &right, int op)
+{
+    PhaseTimer timer(Phase::CHECK);
+    long a, b, r;
+
+
+    if (!result.isNumeric())
+	return Constant();
+
+    if (op == AND && left.known() && left.value() == 0)
+	return Constant(0);
+
+    if (op == OR && left.known() && left.value() != 0)
+	return Constant(1);
+
+    if (!left.known() || !right.known())
+	return Constant();
+
+    a = left.value();
+    b = right.value();
+
+    switch (op) {
+    case '*':
+	if (__builtin_mul_overflow(a, b, &r))
+	    return Constant();
+	break;
+
+    case '/':
+    case '%':
+	if (b == 0 || (a == LONG_MIN && b == -1))
+	    return Constant();
+
+	r = op == '/' ? a / b : a % b;
+	break;
+
+    case '+':
+	if (__builtin_add_overflow(a, b, &r))
+	    return Constant();
+	break;
+
+    case '-':
+	if (__builtin_sub_overflow(a, b, &r))
+	    return Constant();
+	break;
+
+    case '<':
+	return Constant(a < b);
+
+    case '>':
+	return Constant(a > b);
+
+    case LEQ:
+	return Constant(a <= b);
+
+    case GEQ:
+	return Constant(a >= b);
+
+    case EQL:
+	return Constant(a == b);
+
+    case NEQ:
+	return Constant(a != b);
+
+    case AND:
+	return Constant(a && b);
+
+    case OR:
+	return Constant(a || b);
+
+    default:
+	return Constant();
     }
-    report(E4, "=");
-    return error;
-}
\ No newline at end of file
+
+    return target.contains(result.specifier(), r) ? Constant(r) : Constant();
+}
+
+
+/*
+ * Function:	foldUnary
+ *
+ * Description:	Return the value of a unary expression with the given
+ *		RESULT type, whose operand has the value RIGHT.
+ */
+
+Constant foldUnary(const Type &result, const Constant &right, int op)
+{
+    PhaseTimer timer(Phase::CHECK);
+    long r;
+
+
+    if (!result.isNumeric() || !right.known())
+	return Constant();
+
+    if (op == '!')
+	return Constant(!right.value());
+
+    if (op != '-' || __builtin_sub_overflow(0L, right.value(), &r))
+	return Constant();
+
+    return target.contains(result.specifier(), r) ? Constant(r) : Constant();
+}
+
+
+/*
+ * Function:	foldSizeof
+ *
+ * Description:	Return the value of a sizeof expression with the given
+ *		RESULT type, whose operand has type RIGHT.  The operand is
+ *		not promoted, so an array gives the size of all elements.
+ */
+
+Constant foldSizeof(const Type &result, const Type &right)
+{
+    PhaseTimer timer(Phase::CHECK);
+
+
+    if (result.isError())
+	return Constant();
+
+    return Constant(target.size(right));
+}
@@ -7,7 +7,17 @@
 
 # ifndef CHECKER_H
 # define CHECKER_H
+# include <unordered_map>
 # include "Scope.h"
+# include "Constant.h"
+
+typedef std::vector<std::pair<std::string, Symbol *>> Uses;
+typedef std::pair<unsigned, Symbol *> Version;
+
+struct History {
+    std::unordered_map<std::string, std::vector<Version>> versions;
+    unsigned changes = 0;
+};
 
 // static Type integer(INT);
 // static Type error(INT);
@@ -15,10 +25,20 @@
 Scope *openScope();
 Scope *closeScope();
 
+void preserveScopes(History *preserved);
+unsigned snapshotScope();
+void resumeScope(Scope *scope, unsigned snapshot);
+void reopenScope(Scope *scope, unsigned snapshot);
+void releaseScopes();
+Symbol *findGlobal(const std::string &name, unsigned snapshot);
+void recordUses(Uses *uses);
+unsigned frameSize();
+
 Symbol *defineFunction(const std::string &name, const Type &type);
 Symbol *declareFunction(const std::string &name, const Type &type);
 Symbol *declareVariable(const std::string &name, const Type &type);
 Symbol *checkIdentifier(const std::string &name);
+Symbol *importSymbol(const std::string &name, const Type &type);
 
 Type checkLogical(const Type &left, const Type &right, const std::string &op);
 Type checkNot(const Type &right);
@@ -38,8 +58,12 @@ Type checkFor(const Type &left);
 Type checkWhile(const Type &left);
 Type checkReturn(const Type &func, const Type &right);
 
-Type checkFunction(const Type &left, Parameters *params);
+Type checkFunction(const Type &left, const Parameters *params);
 Type checkAssignment(const Type &left, const Type &right, const bool &lvalue);
 
+Constant foldBinary(const Type &result, const Constant &left, const Constant &right, int op);
+Constant foldUnary(const Type &result, const Constant &right, int op);
+Constant foldSizeof(const Type &result, const Type &right);
+
 
 # endif /* CHECKER_H */
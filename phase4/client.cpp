@@ -0,0 +1,169 @@
+/*
+ * File:	client.cpp
+ *
+ * Description:	This file contains the thin client for a compiler server
+ *		for Simple C.  It takes exactly the arguments of the
+ *		compiler, and sends them along with its working directory
+ *		and its standard input, output, and error to the server
+ *		listening on the socket named by SCC_SERVER.  The server
+ *		does everything else, writing to our output and error
+ *		directly, and we then exit with the status it sends back.
+ *
+ *		If SCC_SERVER isn't set, or no server is listening there,
+ *		we simply run the compiler named by SCC, or scc, instead.
+ *
+ *		See server.cpp for the format of a request.
+ *
+ *		Starting the client should cost as little as possible, so
+ *		it uses only the C library.
+ */
+
+# include <cerrno>
+# include <cstdint>
+# include <cstdio>
+# include <cstdlib>
+# include <cstring>
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <unistd.h>
+
+
+/*
+ * Function:	connectServer
+ *
+ * Description:	Connect to the server listening at the given PATH, and
+ *		return the socket, or -1 if there is none.
+ */
+
+static int connectServer(const char *path)
+{
+    struct sockaddr_un address;
+    int fd;
+
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+	return -1;
+
+    strcpy(address.sun_path, path);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+	return -1;
+
+    if (connect(fd, (struct sockaddr *) &address, sizeof(address)) < 0) {
+	close(fd);
+	return -1;
+    }
+
+    return fd;
+}
+
+
+/*
+ * Function:	sendRequest
+ *
+ * Description:	Send a request with the given data to the server over a
+ *		socket, passing our standard descriptors along with its
+ *		length, and return whether we could.
+ */
+
+static bool sendRequest(int fd, const char *data, size_t size)
+{
+    char control[CMSG_SPACE(3 * sizeof(int))];
+    int fds[3] = {0, 1, 2};
+    struct msghdr message;
+    struct cmsghdr *header;
+    struct iovec part;
+    uint32_t length;
+    ssize_t n;
+
+
+    length = size;
+    memset(&message, 0, sizeof(message));
+    memset(control, 0, sizeof(control));
+    part.iov_base = &length;
+    part.iov_len = sizeof(length);
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    if (sendmsg(fd, &message, 0) != sizeof(length))
+	return false;
+
+    for (; size > 0; data += n, size -= n)
+	if ((n = write(fd, data, size)) < 0) {
+	    if (errno != EINTR)
+		return false;
+
+	    n = 0;
+	}
+
+    return true;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Have the server run the compiler with our arguments.
+ */
+
+int main(int argc, char *argv[])
+{
+    const char *path, *compiler;
+    size_t size, length;
+    int32_t status;
+    char *data;
+    int fd;
+
+
+    path = getenv("SCC_SERVER");
+
+    if (path == nullptr || (fd = connectServer(path)) < 0) {
+	compiler = getenv("SCC") != nullptr ? getenv("SCC") : "scc";
+	argv[0] = (char *) compiler;
+	execvp(compiler, argv);
+	fprintf(stderr, "scc-client: cannot run %s\n", compiler);
+	return EXIT_FAILURE;
+    }
+
+    size = 4096;
+
+    for (int i = 1; i < argc; i ++)
+	size += strlen(argv[i]) + 1;
+
+    data = (char *) malloc(size);
+
+    if (data == nullptr || getcwd(data, 4096) == nullptr) {
+	fprintf(stderr, "scc-client: cannot get the working directory\n");
+	return EXIT_FAILURE;
+    }
+
+    length = strlen(data) + 1;
+
+    for (int i = 1; i < argc; i ++) {
+	strcpy(data + length, argv[i]);
+	length += strlen(argv[i]) + 1;
+    }
+
+    if (!sendRequest(fd, data, length)) {
+	fprintf(stderr, "scc-client: cannot send to %s\n", path);
+	return EXIT_FAILURE;
+    }
+
+    if (recv(fd, &status, sizeof(status), MSG_WAITALL) != sizeof(status)) {
+	fprintf(stderr, "scc-client: lost the server at %s\n", path);
+	return EXIT_FAILURE;
+    }
+
+    return status;
+}
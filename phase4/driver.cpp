@@ -0,0 +1,667 @@
+/*
+ * File:	driver.cpp
+ *
+ * Description:	This file contains the public and private function and
+ *		variable definitions for the driver of the compiler for
+ *		Simple C, which reads the command line and runs the parser
+ *		as it says.
+ *
+ *		Extra functionality:
+ *		- checking function bodies in parallel (-j jobs)
+ *		- listing only the global declarations (--skim)
+ *		- only reading the tokens, for timing the lexer (--lex)
+ *		- rendering diagnostics as JSON or SARIF (--diagnostics)
+ *		- stopping after a number of errors (--max-errors)
+ *		- removing duplicate diagnostics (--unique)
+ *		- writing the frame slots of locals and their uses (--slots)
+ *		- writing the value of each full expression whose value is
+ *		  known when checking (--constants)
+ *		- writing counts of symbol table and type system work, and
+ *		  of memory by subsystem, at exit, if compiled in (--stats)
+ *		- starting from the globals of a prelude (--prelude) and
+ *		  writing one (--write-prelude)
+ *		- checking many files at once, in one process (-j jobs
+ *		  file ...)
+ *		- serving requests from a thin client over a Unix domain
+ *		  socket (--serve)
+ *		- reusing the results of checking the same source with the
+ *		  same settings from an on-disk cache (--cache)
+ *		- checking again only the function bodies that changed
+ *		  since the last run, keeping the results of each body in a
+ *		  sidecar file (--incremental)
+ *		- serving an editor over the Language Server Protocol,
+ *		  checking again only the function body that was edited
+ *		  (--lsp), and recording the session (--record)
+ *		- reporting the time spent in each phase at exit
+ *		  (-ftime-report), along with hardware counters if asked
+ *		  (-ftime-counters), and writing a Chrome trace of the
+ *		  function bodies checked (-ftime-trace)
+ *
+ *		When files are named, each is a translation unit of its
+ *		own, checked from start to finish by a single thread of a
+ *		pool, with its own outermost scope, output, and diagnostics.
+ *		The largest files are taken first, so that a large file
+ *		doesn't start last and hold up the rest.  The lexer can
+ *		only read one file at a time, so each thread reads the
+ *		whole file into a buffer and parses from that.  Once every
+ *		file is done, the output and diagnostics of each are
+ *		written in the order in which the files were named.
+ *
+ *		With a cache, every file, or else the standard input, is
+ *		first read into memory to find its key, and a hit is simply
+ *		written out as it was stored, without lexing anything.  Only
+ *		the misses are checked, from the source in memory, and are
+ *		then stored.
+ */
+
+# include <algorithm>
+# include <atomic>
+# include <cstdlib>
+# include <cstring>
+# include <fstream>
+# include <iostream>
+# include <sstream>
+# include <thread>
+# include <sys/stat.h>
+# include "checker.h"
+# include "trace.h"
+# include "tokens.h"
+# include "lexer.h"
+# include "Buffer.h"
+# include "stats.h"
+# include "timing.h"
+# include "prelude.h"
+# include "server.h"
+# include "cache.h"
+# include "sidecar.h"
+# include "incremental.h"
+# include "parser.h"
+# include "lsp.h"
+# include "driver.h"
+
+using namespace std;
+
+struct Unit {
+    const char *path;
+    unsigned long size;
+    bool readable = true, cached = false;
+    string source, key;
+    Cache::Entry entry;
+    Segment segment;
+};
+
+static const char *statistics;
+static const char *compiled;
+static Cache *cache;
+static Sidecar *sidecar;
+static string settings;
+
+
+/*
+ * Function:	readInput
+ *
+ * Description:	Read all of the standard input into SOURCE.  Reading
+ *		through cin a character at a time is far slower.
+ */
+
+static void readInput(string &source)
+{
+    char chunk[65536];
+    size_t n;
+
+
+    while ((n = fread(chunk, 1, sizeof(chunk), stdin)) > 0)
+	source.append(chunk, n);
+}
+
+
+/*
+ * Function:	writeSegments
+ *
+ * Description:	Write the output and diagnostics of the segments of the
+ *		given split unit in order, up to and including the first
+ *		that failed, and return the exit status.
+ */
+
+static int writeSegments(const Split &split)
+{
+    PhaseTimer timer(Phase::OUTPUT);
+    vector<const Diagnostics *> logs;
+    int status = EXIT_SUCCESS;
+
+
+    for (auto segment : split.segments) {
+	cout << segment->output.str();
+	logs.push_back(&segment->diagnostics);
+
+	if (segment->failed) {
+	    status = EXIT_FAILURE;
+	    break;
+	}
+    }
+
+    cout << flush;
+    Diagnostics::render(cerr, logs);
+    return status;
+}
+
+
+/*
+ * Function:	parallel
+ *
+ * Description:	Analyze the standard input stream, checking the function
+ *		bodies using the given number of threads, and return the
+ *		exit status.  With a sidecar, only the bodies not found in
+ *		it are checked, unless there is a limit on errors, since
+ *		then what a body reports depends on the bodies before it.
+ */
+
+static int parallel(unsigned jobs)
+{
+    atomic<unsigned> next(0);
+    vector<string> keys;
+    vector<thread> threads;
+    string source;
+    Buffer tokens;
+    Split split;
+    int status;
+
+
+    if (sidecar != nullptr) {
+	readInput(source);
+	tokens.scan(source);
+    } else
+	tokens.read();
+
+    splitUnit(split, tokens);
+
+    if (sidecar != nullptr && Diagnostics::limit() == 0)
+	replayBodies(split, *sidecar, tokens, source, settings,
+		defaults.dumping || defaults.folding, keys);
+
+    for (unsigned i = 0; i < jobs; i ++)
+	threads.push_back(thread(checkBodies, &split, &tokens, &next,
+		sidecar != nullptr));
+
+    for (auto &t : threads) {
+	PhaseTimer timer(Phase::WAIT);
+	t.join();
+    }
+
+    if (sidecar != nullptr && Diagnostics::limit() == 0)
+	rememberBodies(split, *sidecar, tokens, keys);
+
+    status = writeSegments(split);
+    releaseUnit(split);
+    return status;
+}
+
+
+/*
+ * Function:	checkFiles
+ *
+ * Description:	Check the units taken in the given ORDER, starting at the
+ *		one indexed by NEXT, until there are none left.  Each thread
+ *		running this function takes the next unit, reads it into
+ *		its buffer, and checks all of it.  If the prelude can't be
+ *		read, we set UNSEEDED and every thread stops, leaving the
+ *		main thread to report it and fail once they have joined.
+ */
+
+static void checkFiles(vector<Unit> *units, const vector<unsigned> *order,
+	atomic<unsigned> *next, atomic<bool> *unseeded)
+{
+    Buffer tokens;
+    unsigned i;
+
+
+    while (!*unseeded && (i = (*next) ++) < order->size()) {
+	Unit &unit = (*units)[(*order)[i]];
+
+	output = &unit.segment.output;
+	diagnostics = &unit.segment.diagnostics;
+
+	if (unit.cached)
+	    continue;
+
+	if (cache != nullptr ? !tokens.scan(unit.source) : !tokens.read(unit.path)) {
+	    unit.readable = false;
+	    continue;
+	}
+
+	try {
+	    SpanTimer span("file", unit.path);
+
+	    if (!checkUnit(tokens, defaults.prelude, defaults.dumping, defaults.folding))
+		unit.segment.failed = true;
+
+	} catch (PreludeError &) {
+	    *unseeded = true;
+	    return;
+	}
+    }
+}
+
+
+/*
+ * Function:	load
+ *
+ * Description:	Read the source of a unit into memory, and look up its
+ *		results in the cache.  A unit without a path is the
+ *		standard input.  Return whether the source could be read.
+ */
+
+static bool load(Unit &unit)
+{
+    ostringstream source;
+    ifstream file;
+
+
+    if (*unit.path == '\0')
+	readInput(unit.source);
+
+    else {
+	file.open(unit.path, ios::binary);
+
+	if (!file)
+	    return false;
+
+	source << file.rdbuf();
+	unit.source = source.str();
+    }
+
+    unit.size = unit.source.size();
+    unit.key = Cache::key(unit.source, settings + unit.path);
+    unit.cached = cache->find(unit.key, unit.entry);
+    return true;
+}
+
+
+/*
+ * Function:	compile
+ *
+ * Description:	Analyze the files at the given PATHS, checking as many at
+ *		once as the given number of threads, and return the exit
+ *		status, which is a failure if any file failed.  An empty
+ *		path is the standard input.
+ */
+
+static int compile(const vector<const char *> &paths, unsigned jobs)
+{
+    vector<Unit> units(paths.size());
+    atomic<unsigned> next(0);
+    atomic<bool> unseeded(false);
+    vector<unsigned> order;
+    vector<thread> threads;
+    struct stat status;
+    int result;
+
+
+    for (unsigned i = 0; i < paths.size(); i ++) {
+	units[i].path = paths[i];
+	units[i].size = stat(paths[i], &status) == 0 ? status.st_size : 0;
+	order.push_back(i);
+
+	if (cache != nullptr && !load(units[i]))
+	    units[i].readable = false;
+    }
+
+    stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+	return units[a].size > units[b].size;
+    });
+
+    jobs = max(1u, min(jobs, (unsigned) paths.size()));
+
+    for (unsigned i = 0; i < jobs; i ++)
+	threads.push_back(thread(checkFiles, &units, &order, &next, &unseeded));
+
+    for (auto &t : threads) {
+	PhaseTimer timer(Phase::WAIT);
+	t.join();
+    }
+
+    if (unseeded) {
+	cerr << "scc: cannot read prelude " << defaults.prelude << endl;
+	return EXIT_FAILURE;
+    }
+
+    result = EXIT_SUCCESS;
+
+    for (auto &unit : units) {
+	PhaseTimer timer(Phase::OUTPUT);
+
+	if (!unit.readable) {
+	    cerr << "scc: cannot read " << unit.path << endl;
+	    result = EXIT_FAILURE;
+	    continue;
+	}
+
+	if (!unit.cached) {
+	    ostringstream errors;
+
+	    Diagnostics::render(errors, {&unit.segment.diagnostics}, unit.path);
+	    unit.entry.status = unit.segment.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+	    unit.entry.output = unit.segment.output.str();
+	    unit.entry.errors = errors.str();
+
+	    if (cache != nullptr)
+		cache->store(unit.key, unit.entry);
+	}
+
+	cout << unit.entry.output << flush;
+	cerr.write(unit.entry.errors.data(), unit.entry.errors.size());
+	cerr.flush();
+
+	if (unit.entry.status != EXIT_SUCCESS)
+	    result = EXIT_FAILURE;
+    }
+
+    if (cache != nullptr)
+	cache->update();
+
+    return result;
+}
+
+
+/*
+ * Function:	writeSignatures
+ *
+ * Description:	Write the name and type of each symbol in the given scope.
+ */
+
+static void writeSignatures(ostream &ostr, const Scope *scope)
+{
+    PhaseTimer timer(Phase::OUTPUT);
+
+
+    for (auto symbol : scope->symbols()) {
+	ostr << symbol->name() << ": ";
+	writeSignature(ostr, symbol->type());
+	ostr << "\n";
+    }
+}
+
+
+/*
+ * Function:	skim
+ *
+ * Description:	Analyze the global declarations of the standard input
+ *		stream, skipping the function bodies, and write the
+ *		signatures in the outermost scope.
+ */
+
+static int skim()
+{
+    ostream discard(nullptr);
+    Scope *globals;
+
+
+    output = &discard;
+    globals = checkInput(true);
+    writeSignatures(cout, globals);
+    return finish(EXIT_SUCCESS);
+}
+
+
+/*
+ * Function:	lex
+ *
+ * Description:	Read the tokens of the standard input stream and nothing
+ *		else.  Only lexical errors are reported.
+ */
+
+static int lex()
+{
+    while (yylex() != DONE)
+	continue;
+
+    return finish(EXIT_SUCCESS);
+}
+
+
+/*
+ * Function:	writeStatistics
+ *
+ * Description:	Write the statistics to the file given with --stats, or to
+ *		the standard error if none was given.  This is called at
+ *		exit, since there are many ways out of the parser.
+ */
+
+static void writeStatistics()
+{
+    ofstream file;
+
+
+    if (*statistics == '\0')
+	stats::write(cerr);
+
+    else {
+	file.open(statistics);
+
+	if (!file) {
+	    cerr << "scc: cannot write " << statistics << endl;
+	    return;
+	}
+
+	stats::write(file);
+    }
+}
+
+
+/*
+ * Function:	usage
+ *
+ * Description:	Write how to use the program, and exit.
+ */
+
+static void usage(const char *program)
+{
+    cerr << "usage: " << program << " [--lex] [--skim] [-j jobs]";
+    cerr << " [--diagnostics=text|json|sarif] [--max-errors=n]";
+    cerr << " [--unique] [--slots] [--constants] [--prelude=file]";
+    cerr << " [--write-prelude=file] [--cache=dir]";
+    cerr << " [--cache-size=bytes] [--cache-stats] [--incremental=file]";
+    cerr << " [--lsp]";
+    cerr << " [--record=file] [-ftime-report] [-ftime-counters]";
+    cerr << " [-ftime-trace=file]";
+
+    if (stats::enabled)
+	cerr << " [--stats[=file]]";
+
+    cerr << " [file ...]" << endl;
+    cerr << "       " << program << " --serve=socket [--prelude=file]" << endl;
+    exit(EXIT_FAILURE);
+}
+
+
+/*
+ * Function:	run
+ *
+ * Description:	Analyze the standard input stream, or the named files,
+ *		as the arguments say, and return the exit status.
+ */
+
+static int run(int argc, char *argv[])
+{
+    unsigned jobs = 1, limit = 0;
+    bool skimOnly = false, lexOnly = false, unique = false;
+    Diagnostics::Format format = Diagnostics::TEXT;
+    vector<const char *> paths;
+    const char *directory = nullptr, *incremental = nullptr;
+    unsigned long size = 64ul << 20;
+    bool reporting = false, speaking = false;
+    bool timed = false, counted = false;
+    const char *record = nullptr, *traced = nullptr;
+    ostringstream contents;
+    ifstream file;
+    Scope *globals;
+    int status;
+
+
+    for (int i = 1; i < argc; i ++)
+	if (strcmp(argv[i], "--skim") == 0)
+	    skimOnly = true;
+	else if (strcmp(argv[i], "--lex") == 0)
+	    lexOnly = true;
+	else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+	    jobs = strtoul(argv[++ i], NULL, 0);
+	else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0')
+	    jobs = strtoul(argv[i] + 2, NULL, 0);
+	else if (strcmp(argv[i], "--diagnostics=text") == 0)
+	    format = Diagnostics::TEXT;
+	else if (strcmp(argv[i], "--diagnostics=json") == 0)
+	    format = Diagnostics::JSON;
+	else if (strcmp(argv[i], "--diagnostics=sarif") == 0)
+	    format = Diagnostics::SARIF;
+	else if (strncmp(argv[i], "--max-errors=", 13) == 0)
+	    limit = strtoul(argv[i] + 13, NULL, 0);
+	else if (strcmp(argv[i], "--unique") == 0)
+	    unique = true;
+	else if (strcmp(argv[i], "--slots") == 0)
+	    defaults.dumping = true;
+	else if (strcmp(argv[i], "--constants") == 0)
+	    defaults.folding = true;
+	else if (strcmp(argv[i], "--stats") == 0 && stats::enabled)
+	    statistics = "";
+	else if (strncmp(argv[i], "--stats=", 8) == 0 && stats::enabled)
+	    statistics = argv[i] + 8;
+	else if (strncmp(argv[i], "--prelude=", 10) == 0)
+	    defaults.prelude = argv[i] + 10;
+	else if (strncmp(argv[i], "--write-prelude=", 16) == 0)
+	    compiled = argv[i] + 16;
+	else if (strncmp(argv[i], "--cache=", 8) == 0)
+	    directory = argv[i] + 8;
+	else if (strncmp(argv[i], "--cache-size=", 13) == 0)
+	    size = strtoul(argv[i] + 13, NULL, 0);
+	else if (strcmp(argv[i], "--cache-stats") == 0)
+	    reporting = true;
+	else if (strncmp(argv[i], "--incremental=", 14) == 0)
+	    incremental = argv[i] + 14;
+	else if (strcmp(argv[i], "--lsp") == 0)
+	    speaking = true;
+	else if (strncmp(argv[i], "--record=", 9) == 0)
+	    record = argv[i] + 9;
+	else if (strcmp(argv[i], "-ftime-report") == 0)
+	    timed = true;
+	else if (strcmp(argv[i], "-ftime-counters") == 0)
+	    counted = true;
+	else if (strncmp(argv[i], "-ftime-trace=", 13) == 0)
+	    traced = argv[i] + 13;
+	else if (argv[i][0] != '-')
+	    paths.push_back(argv[i]);
+	else
+	    usage(argv[0]);
+
+    Diagnostics::configure(format, limit, unique);
+    diagnostics = &standard;
+
+    if (statistics != nullptr)
+	atexit(writeStatistics);
+
+    if (timed || counted || traced != nullptr)
+	startTiming(timed || (counted && traced == nullptr), counted, traced);
+
+    if (speaking) {
+	if (!paths.empty() || lexOnly || skimOnly || compiled != nullptr ||
+		directory != nullptr || incremental != nullptr) {
+	    cerr << "scc: --lsp reads only the messages of an editor" << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	Diagnostics::configure(format, 0, unique);
+	return edit(record);
+    }
+
+    if (directory != nullptr) {
+	cache = new Cache(directory, size);
+
+	if (reporting) {
+	    cache->report(cout);
+	    exit(EXIT_SUCCESS);
+	}
+    }
+
+    if (directory != nullptr || incremental != nullptr) {
+	if (defaults.prelude != nullptr) {
+	    file.open(defaults.prelude, ios::binary);
+	    contents << file.rdbuf();
+	}
+
+	settings = to_string(format) + " " + to_string(limit) + " " +
+	    to_string(unique) + " " + to_string(defaults.dumping) + " " +
+	    to_string(defaults.folding) + " " + contents.str() + "\n";
+    }
+
+    if (incremental != nullptr) {
+	if (!paths.empty() || cache != nullptr || lexOnly || skimOnly ||
+		compiled != nullptr) {
+	    cerr << "scc: --incremental only checks the standard input,";
+	    cerr << " without a cache" << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	sidecar = new Sidecar(incremental);
+	exit(parallel(max(jobs, 1u)));
+    }
+
+    if (!paths.empty() || cache != nullptr) {
+	if (lexOnly || skimOnly || compiled != nullptr) {
+	    cerr << "scc: --lex, --skim, and --write-prelude only read";
+	    cerr << " the standard input, without a cache" << endl;
+	    exit(EXIT_FAILURE);
+	}
+
+	if (paths.empty())
+	    paths.push_back("");
+
+	exit(compile(paths, jobs));
+    }
+
+    if (lexOnly)
+	exit(lex());
+
+    if (skimOnly)
+	exit(skim());
+
+    if (jobs > 1 && compiled == nullptr)
+	exit(parallel(jobs));
+
+    globals = checkInput(false);
+    status = finish(EXIT_SUCCESS);
+
+    if (compiled != nullptr) {
+	if (numerrors > 0 || !writePrelude(compiled, globals)) {
+	    cerr << "scc: cannot write prelude " << compiled << endl;
+	    status = EXIT_FAILURE;
+	}
+    }
+
+    return status;
+}
+
+
+/*
+ * Function:	command
+ *
+ * Description:	Analyze the standard input stream, or the named files, or
+ *		serve requests to do so, and return the exit status.  A
+ *		server warms up by checking the prelude, if given, so that
+ *		its types are already interned and its pages cached when a
+ *		request reads it.
+ */
+
+int command(int argc, char *argv[])
+{
+    if (argc < 2 || strncmp(argv[1], "--serve=", 8) != 0)
+	return run(argc, argv);
+
+    for (int i = 2; i < argc; i ++)
+	if (strncmp(argv[i], "--prelude=", 10) == 0)
+	    defaults.prelude = argv[i] + 10;
+	else
+	    usage(argv[0]);
+
+    checkPrelude();
+    defaults.prelude = nullptr;
+    return serve(argv[1] + 8, run);
+}
@@ -0,0 +1,13 @@
+/*
+ * File:	driver.h
+ *
+ * Description:	This file contains the function declarations for the
+ *		driver of the compiler for Simple C.
+ */
+
+# ifndef DRIVER_H
+# define DRIVER_H
+
+int command(int argc, char *argv[]);
+
+# endif /* DRIVER_H */
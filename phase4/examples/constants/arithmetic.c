@@ -0,0 +1,15 @@
+int x;
+
+int main(void)
+{
+    x = 2 + 3 * 4;
+    x = (2 + 3) * 4;
+    x = 17 / 5;
+    x = 17 % 5;
+    x = -17 / 5;
+    x = -17 % 5;
+    x = 7 - 10;
+    x = 'a' + 1;
+    x = x + 1;
+    return 0;
+}
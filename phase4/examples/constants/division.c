@@ -0,0 +1,13 @@
+int x;
+
+int main(void)
+{
+    x = 1 / 0;
+    x = 1 % 0;
+    x = 0 / 1;
+    x = 5 / (3 - 3);
+    x = 0 && 1 / 0;
+    x = 1 || 1 / 0;
+    x = 1 && 1 / 0;
+    return 1 / 0;
+}
@@ -0,0 +1,19 @@
+int i;
+long l;
+
+int main(void)
+{
+    i = 2147483647;
+    i = 2147483647 + 1;
+    i = -2147483647 - 1;
+    i = -2147483647 - 2;
+    i = 65536 * 65536;
+    l = 65536 * 65536;
+    l = 4294967296;
+    l = 4294967296 * 2;
+    l = 9223372036854775807 + 1;
+    l = -9223372036854775807 - 1;
+    l = (-9223372036854775807 - 1) / -1;
+    i = -(-2147483647 - 1);
+    return 0;
+}
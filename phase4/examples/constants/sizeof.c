@@ -0,0 +1,19 @@
+char c, s[10];
+int i, a[10], *p, *q[3];
+long l, b[4];
+
+int main(void)
+{
+    i = sizeof c;
+    i = sizeof s;
+    i = sizeof i;
+    i = sizeof a;
+    i = sizeof p;
+    i = sizeof q;
+    i = sizeof l;
+    i = sizeof b;
+    i = sizeof "hello";
+    i = sizeof (a[0] + 1);
+    i = sizeof sizeof a;
+    return 0;
+}
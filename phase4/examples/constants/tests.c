@@ -0,0 +1,11 @@
+int x;
+
+int main(void)
+{
+    if (1 < 2) x = 1;
+    if (2 <= 1) x = 0;
+    while (3 == 3) x = !0;
+    for (x = 0; 4 != 4; x = x + 1) x = !7;
+    if (x) x = 0 || 0;
+    return 'z' > 'a';
+}
@@ -0,0 +1,50 @@
+int a, b[10], *p;
+char c;
+long l;
+void v;
+int f(), g();
+int f();
+long f();
+int h(int x, char *y) { return x; }
+int h(int x, char *y) { return y; }
+int k(int x, int x) { int x; return 0; }
+int m(void)
+{
+    int i, i;
+    char s[4];
+    i = undefined + 1;
+    i = undefined;
+    i = a * p;
+    i = -p;
+    i = !b;
+    i = *a;
+    i = &5;
+    i = sizeof f;
+    i = sizeof a * 10;
+    i = p - b;
+    i = p + p;
+    i = a[b];
+    p = b + 3;
+    i = a < p;
+    i = p < b;
+    i = p == c;
+    i = p != 3;
+    i = a && v;
+    i = a || b;
+    a();
+    h(1);
+    h(1, 2);
+    h(1, s);
+    g(v);
+    5 = a;
+    i = p;
+    while (v) i = i;
+    for (i = 0; f; i = i + 1) a = a;
+    if (m) a = 1; else a = 2;
+    { int z; char *q; q = &z; z = *q; }
+    return p;
+}
+long n(long q) { return q * 2 - 1 % 3 / 4; }
+int z(void) { return later; }
+int later;
+int y(void) { return later + m(); }
@@ -0,0 +1,3 @@
+int printf();
+int main(void) { printf("%d\n", 99); return 0 + 'x' + "abc\q"; }
+/* unterminated
@@ -0,0 +1,3 @@
+int a;
+int f(void) { return a + ; }
+int g(void) { return 1; }
@@ -0,0 +1,3 @@
+int f(void) { int a; a = 1; }
+int b
+int g(void) { return 1; }
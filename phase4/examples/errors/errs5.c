@@ -0,0 +1,2 @@
+int f(void) { int a; a = 1; { a = 2; }
+int g(void) { return 1; }
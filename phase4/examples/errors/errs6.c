@@ -0,0 +1,2 @@
+int f(void) { int a; a = 1; } }
+int g(void) { return 1; }
@@ -0,0 +1,5 @@
+int f(int a) { return a; }
+int g(void) { return f(1) + f(2,3); }
+int f(char *s);
+int f(char *s) { return 0; }
+int h(void) { return f("x"); }
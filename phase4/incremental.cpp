@@ -0,0 +1,170 @@
+/*
+ * File:	incremental.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for checking a translation unit incrementally
+ *		in Simple C.
+ *
+ *		The input is analyzed just as when checking in parallel,
+ *		but before the bodies are checked each is given a key made
+ *		from the text of its definition.  A body whose key is in the
+ *		sidecar, and whose globals, as recorded when it was last
+ *		checked, are still the same as of its snapshot of the
+ *		outermost scope, has its output and diagnostics replayed
+ *		from there instead of being checked.  The globals themselves
+ *		are always checked, so everything written is what checking
+ *		all of it would write.
+ */
+
+# include <algorithm>
+# include <sstream>
+# include <unordered_map>
+# include "checker.h"
+# include "cache.h"
+# include "parser.h"
+# include "incremental.h"
+
+using namespace std;
+
+
+/*
+ * Function:	describe
+ *
+ * Description:	Return the key of a deferred function body, made from the
+ *		text of its definition, up to the next token.  The text
+ *		gives its name, return type, and parameters, its tokens and
+ *		their lines relative to each other, and anything the lexer
+ *		reported for them.  Only if LINES are written, as they are
+ *		with slots and constants, does the line on which the body
+ *		starts matter.
+ */
+
+static string describe(const Body &body, const Buffer &tokens,
+	const string &source, const string &settings, bool lines)
+{
+    unsigned from = tokens[body.first].offset;
+    unsigned to = body.end < tokens.size() ? tokens[body.end].offset : source.size();
+
+
+    if (lines)
+	return Cache::key(source.substr(from, to - from), settings + to_string(tokens[body.begin].line));
+
+    return Cache::key(source.substr(from, to - from), settings);
+}
+
+
+/*
+ * Function:	replayBodies
+ *
+ * Description:	Look up each deferred body of the given split unit in the
+ *		sidecar, and if every global it named when it was checked
+ *		is still the same at its snapshot, fill in its segment just
+ *		as checking it would, with its diagnostics moved to where
+ *		the body now starts.  The bodies replayed are settled at
+ *		once and never checked.  Many bodies name the same globals,
+ *		so each global is only written out once.  The key of each
+ *		body is added to KEYS.
+ */
+
+void replayBodies(Split &split, Sidecar &sidecar, const Buffer &tokens,
+	const string &source, const string &settings, bool lines,
+	vector<string> &keys)
+{
+    unordered_map<const Symbol *, string> types;
+    Sidecar::Entry entry;
+    bool unchanged;
+    Symbol *symbol;
+    int first;
+
+
+    for (auto &body : split.bodies) {
+	keys.push_back(describe(body, tokens, source, settings, lines));
+
+	if (!sidecar.find(keys.back(), entry))
+	    continue;
+
+	unchanged = true;
+
+	for (unsigned i = 0; i < entry.uses.size() && unchanged; i ++) {
+	    symbol = findGlobal(entry.uses[i].first, body.snapshot);
+
+	    if (symbol != nullptr && types.count(symbol) == 0) {
+		ostringstream type;
+
+		writeSignature(type, symbol->type());
+		types[symbol] = type.str();
+	    }
+
+	    unchanged = entry.uses[i].second == (symbol != nullptr ? types[symbol] : "");
+	}
+
+	if (!unchanged)
+	    continue;
+
+	first = tokens[body.begin].line;
+	body.segment->output << entry.output;
+	body.segment->failed = entry.failed;
+
+	for (auto &note : entry.notes)
+	    body.segment->diagnostics.add(Diagnostic {Diagnostics::atom(Diagnostics::known(note.message)),
+		    Diagnostics::atom(note.argument), note.line + first});
+
+	body.replayed = true;
+	settleBody(split, body);
+    }
+}
+
+
+/*
+ * Function:	rememberBodies
+ *
+ * Description:	Store the results of each body of the given split unit
+ *		that was checked in the sidecar, with the lines of its
+ *		diagnostics relative to the start of the body and each
+ *		global it named once, and write the sidecar.  Failing to
+ *		write it is not an error, since it only means checking
+ *		everything the next time.
+ */
+
+void rememberBodies(Split &split, Sidecar &sidecar, const Buffer &tokens,
+	const vector<string> &keys)
+{
+    Sidecar::Entry entry;
+    int first;
+
+
+    for (unsigned i = 0; i < split.bodies.size(); i ++) {
+	Body &body = split.bodies[i];
+	const Diagnostics &log = body.segment->diagnostics;
+
+	if (body.replayed)
+	    continue;
+
+	first = tokens[body.begin].line;
+	entry.failed = body.segment->failed;
+	entry.output = body.segment->output.str();
+	entry.notes.clear();
+	entry.uses.clear();
+
+	for (unsigned j = 0; j < log.size(); j ++)
+	    entry.notes.push_back(Sidecar::Note {log[j].line - first,
+		    (unsigned) Diagnostics::number(Diagnostics::spelling(log[j].id)),
+		    Diagnostics::spelling(log[j].argument)});
+
+	sort(body.uses.begin(), body.uses.end());
+	body.uses.erase(unique(body.uses.begin(), body.uses.end()), body.uses.end());
+
+	for (auto &use : body.uses) {
+	    ostringstream type;
+
+	    if (use.second != nullptr)
+		writeSignature(type, use.second->type());
+
+	    entry.uses.push_back(make_pair(use.first, type.str()));
+	}
+
+	sidecar.store(keys[i], entry);
+    }
+
+    sidecar.write();
+}
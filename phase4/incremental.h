@@ -0,0 +1,26 @@
+/*
+ * File:	incremental.h
+ *
+ * Description:	This file contains the function declarations for checking
+ *		a translation unit incrementally in Simple C, replaying the
+ *		results of the function bodies that haven't changed since
+ *		the last run from a sidecar, and storing the results of the
+ *		ones that were checked.
+ */
+
+# ifndef INCREMENTAL_H
+# define INCREMENTAL_H
+# include <string>
+# include <vector>
+# include "Buffer.h"
+# include "parser.h"
+# include "sidecar.h"
+
+void replayBodies(Split &split, Sidecar &sidecar, const Buffer &tokens,
+	const std::string &source, const std::string &settings, bool lines,
+	std::vector<std::string> &keys);
+
+void rememberBodies(Split &split, Sidecar &sidecar, const Buffer &tokens,
+	const std::vector<std::string> &keys);
+
+# endif /* INCREMENTAL_H */
@@ -589,6 +589,12 @@ char *yytext;
  *		Extra functionality:
  *		- checking for out of range integer literals
  *		- checking for invalid string literals
+ *		- skipping balanced braces without breaking them into tokens
+ *		- tracking the offset in the input of the end of the text
+ *		  read so far (yyoffset)
+ *		- charging the time spent reading tokens and skipping
+ *		  braces to the lex phase (timing.h)
+ *		- accounting for the buffers of the lexer (stats.h)
  */
 
 # include <cerrno>
@@ -598,17 +604,29 @@ char *yytext;
 # include "string.h"
 # include "tokens.h"
 # include "lexer.h"
+# include "timing.h"
+# include "stats.h"
 
 
+# define YY_DECL static int scan()
+# define YY_USER_ACTION yyoffset += yyleng;
+
+# define malloc(size) stats::allocate(size, Memory::LEXER)
+# define realloc(pointer, size) stats::reallocate(pointer, size)
+# define free(pointer) stats::deallocate(pointer)
+
 using namespace std;
 
-int numerrors = 0;
+unsigned yyoffset;
+
+static int scan();
+static int next();
 static void checkInt();
 static void checkStr();
 static void checkChar();
 static void ignoreComment();
-#line 611 "<stdout>"
-#line 612 "<stdout>"
+#line 629 "<stdout>"
+#line 630 "<stdout>"
 
 #define INITIAL 0
 
@@ -823,10 +841,10 @@ YY_DECL
 		}
 
 	{
-#line 32 "lexer.l"
+#line 50 "lexer.l"
 
 
-#line 830 "<stdout>"
+#line 848 "<stdout>"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -895,256 +913,256 @@ do_action:	/* This label is used only to access EOF actions. */
 
 case 1:
 YY_RULE_SETUP
-#line 34 "lexer.l"
+#line 52 "lexer.l"
 {ignoreComment();}
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 36 "lexer.l"
+#line 54 "lexer.l"
 {return AUTO;}
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 37 "lexer.l"
+#line 55 "lexer.l"
 {return BREAK;}
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 38 "lexer.l"
+#line 56 "lexer.l"
 {return CASE;}
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 39 "lexer.l"
+#line 57 "lexer.l"
 {return CHAR;}
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 40 "lexer.l"
+#line 58 "lexer.l"
 {return CONST;}
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 41 "lexer.l"
+#line 59 "lexer.l"
 {return CONTINUE;}
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 42 "lexer.l"
+#line 60 "lexer.l"
 {return DEFAULT;}
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 43 "lexer.l"
+#line 61 "lexer.l"
 {return DO;}
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 44 "lexer.l"
+#line 62 "lexer.l"
 {return DOUBLE;}
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 45 "lexer.l"
+#line 63 "lexer.l"
 {return ELSE;}
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 46 "lexer.l"
+#line 64 "lexer.l"
 {return ENUM;}
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 47 "lexer.l"
+#line 65 "lexer.l"
 {return EXTERN;}
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 48 "lexer.l"
+#line 66 "lexer.l"
 {return FLOAT;}
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 49 "lexer.l"
+#line 67 "lexer.l"
 {return FOR;}
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 50 "lexer.l"
+#line 68 "lexer.l"
 {return GOTO;}
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 51 "lexer.l"
+#line 69 "lexer.l"
 {return IF;}
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 52 "lexer.l"
+#line 70 "lexer.l"
 {return INT;}
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 53 "lexer.l"
+#line 71 "lexer.l"
 {return LONG;}
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 54 "lexer.l"
+#line 72 "lexer.l"
 {return REGISTER;}
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 55 "lexer.l"
+#line 73 "lexer.l"
 {return RETURN;}
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 56 "lexer.l"
+#line 74 "lexer.l"
 {return SHORT;}
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 57 "lexer.l"
+#line 75 "lexer.l"
 {return SIGNED;}
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 58 "lexer.l"
+#line 76 "lexer.l"
 {return SIZEOF;}
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 59 "lexer.l"
+#line 77 "lexer.l"
 {return STATIC;}
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 60 "lexer.l"
+#line 78 "lexer.l"
 {return STRUCT;}
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
-#line 61 "lexer.l"
+#line 79 "lexer.l"
 {return SWITCH;}
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
-#line 62 "lexer.l"
+#line 80 "lexer.l"
 {return TYPEDEF;}
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
-#line 63 "lexer.l"
+#line 81 "lexer.l"
 {return UNION;}
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 64 "lexer.l"
+#line 82 "lexer.l"
 {return UNSIGNED;}
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
-#line 65 "lexer.l"
+#line 83 "lexer.l"
 {return VOID;}
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 66 "lexer.l"
+#line 84 "lexer.l"
 {return VOLATILE;}
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 67 "lexer.l"
+#line 85 "lexer.l"
 {return WHILE;}
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 69 "lexer.l"
+#line 87 "lexer.l"
 {return OR;}
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 70 "lexer.l"
+#line 88 "lexer.l"
 {return AND;}
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 71 "lexer.l"
+#line 89 "lexer.l"
 {return EQL;}
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 72 "lexer.l"
+#line 90 "lexer.l"
 {return NEQ;}
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 73 "lexer.l"
+#line 91 "lexer.l"
 {return LEQ;}
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 74 "lexer.l"
+#line 92 "lexer.l"
 {return GEQ;}
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
-#line 75 "lexer.l"
+#line 93 "lexer.l"
 {return INC;}
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
-#line 76 "lexer.l"
+#line 94 "lexer.l"
 {return DEC;}
 	YY_BREAK
 case 42:
 YY_RULE_SETUP
-#line 77 "lexer.l"
+#line 95 "lexer.l"
 {return ARROW;}
 	YY_BREAK
 case 43:
 YY_RULE_SETUP
-#line 78 "lexer.l"
+#line 96 "lexer.l"
 {return *yytext;}
 	YY_BREAK
 case 44:
 YY_RULE_SETUP
-#line 80 "lexer.l"
+#line 98 "lexer.l"
 {return ID;}
 	YY_BREAK
 case 45:
 YY_RULE_SETUP
-#line 82 "lexer.l"
+#line 100 "lexer.l"
 {checkInt(); return NUM;}
 	YY_BREAK
 case 46:
 YY_RULE_SETUP
-#line 83 "lexer.l"
+#line 101 "lexer.l"
 {checkStr(); return STRING;}
 	YY_BREAK
 case 47:
 YY_RULE_SETUP
-#line 84 "lexer.l"
+#line 102 "lexer.l"
 {checkChar(); return CHARACTER;}
 	YY_BREAK
 case 48:
 /* rule 48 can match eol */
 YY_RULE_SETUP
-#line 86 "lexer.l"
+#line 104 "lexer.l"
 {/* ignored */}
 	YY_BREAK
 case 49:
 YY_RULE_SETUP
-#line 87 "lexer.l"
+#line 105 "lexer.l"
 {return ERROR;}
 	YY_BREAK
 case 50:
 YY_RULE_SETUP
-#line 89 "lexer.l"
+#line 107 "lexer.l"
 ECHO;
 	YY_BREAK
-#line 1148 "<stdout>"
+#line 1166 "<stdout>"
 case YY_STATE_EOF(INITIAL):
 	yyterminate();
 
@@ -2120,7 +2138,38 @@ void yyfree (void * ptr )
 
 #define YYTABLES_NAME "yytables"
 
-#line 89 "lexer.l"
+#line 107 "lexer.l"
+
+
+/*
+ * Function:	yylex
+ *
+ * Description:	Read the next token, charging the time to the lex phase.
+ */
+
+int yylex()
+{
+    PhaseTimer timer(Phase::LEX);
+    return scan();
+}
+
+
+/*
+ * Function:	next
+ *
+ * Description:	Read the next character of the input directly, counting
+ *		it in the offset.  Zero is returned at the end of the input.
+ */
+
+static int next()
+{
+    int c = yyinput();
+
+    if (c != 0)
+	yyoffset ++;
+
+    return c;
+}
 
 
 /*
@@ -2134,9 +2183,9 @@ static void ignoreComment()
     int c1, c2;
 
 
-    while ((c1 = yyinput()) != 0) {
+    while ((c1 = next()) != 0) {
 	while (c1 == '*') {
-	    if ((c2 = yyinput()) == '/' || c2 == 0)
+	    if ((c2 = next()) == '/' || c2 == 0)
 		return;
 
 	    c1 = c2;
@@ -2148,6 +2197,54 @@ static void ignoreComment()
 }
 
 
+/*
+ * Function:	skipBraces
+ *
+ * Description:	Skip the input up to and including the closing brace that
+ *		matches an opening brace just recognized, without breaking
+ *		it into tokens.  We still have to recognize comments and
+ *		literals, since they may contain braces, but we don't check
+ *		them.  Return whether the closing brace was found.
+ */
+
+bool skipBraces()
+{
+    PhaseTimer timer(Phase::LEX);
+    int c, quote, depth = 1;
+
+
+    c = next();
+
+    while (c != 0) {
+	if (c == '/') {
+	    if ((c = next()) == '*') {
+		ignoreComment();
+		c = next();
+	    }
+
+	    continue;
+
+	} else if (c == '"' || c == '\'') {
+	    quote = c;
+
+	    while ((c = next()) != 0 && c != quote && c != '\n')
+		if (c == '\\' && next() == 0)
+		    return false;
+
+	} else if (c == '{')
+	    depth ++;
+
+	else if (c == '}' && -- depth == 0)
+	    return true;
+
+	if (c != 0)
+	    c = next();
+    }
+
+    return false;
+}
+
+
 /*
  * Function:	checkInt
  *
@@ -2206,23 +2303,3 @@ static void checkChar()
 }
 
 
-/*
- * Function:	report
- *
- * Description:	Report an error to the standard error prefixed with the
- *		line number.  We'll be using this a lot later with an
- *		optional string argument, but C++'s stupid streams don't do
- *		positional arguments, so we actually resort to snprintf.
- *		You just can't beat C for doing things down and dirty.
- */
-
-void report(const string &str, const string &arg)
-{
-    char buf[1000];
-
-
-    snprintf(buf, sizeof(buf), str.c_str(), arg.c_str());
-    cerr << "line " << yylineno << ": " << buf << endl;
-    numerrors ++;
-}
-
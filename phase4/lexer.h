@@ -7,12 +7,16 @@
 
 # ifndef LEXER_H
 # define LEXER_H
-# include <string>
+# include <cstdio>
+# include "Diagnostics.h"
 
 extern char *yytext;
-extern int yylineno, numerrors;
+extern int yyleng;
+extern int yylineno;
+extern unsigned yyoffset;
 
 extern int yylex();
-extern void report(const std::string &str, const std::string &arg = "");
+extern void yyrestart(FILE *file);
+extern bool skipBraces();
 
 # endif /* LEXER_H */
@@ -0,0 +1,998 @@
+/*
+ * File:	lsp.cpp
+ *
+ * Description:	This file contains the function definitions for speaking
+ *		the Language Server Protocol in Simple C, and for analyzing
+ *		the documents being edited.
+ *
+ *		A message is a JSON object preceded by a header giving its
+ *		length, and we parse just enough JSON to read the messages
+ *		an editor sends.  A message with no length we can use, or
+ *		one longer than we're willing to hold, is refused.  We handle initializing and shutting down,
+ *		and the opening, changing, and closing of documents, and
+ *		answer any other request with an error.  Once a document is
+ *		opened or changed, its diagnostics are published, each one
+ *		covering the whole of its line.
+ *
+ *		Documents are synchronized incrementally, so a change is a
+ *		range of the text and what replaces it, which is passed on
+ *		to the analyzer as an edit.  A change may instead replace
+ *		the whole text, in which case we find the edit by comparing
+ *		the old text with the new.  Positions are counted in bytes,
+ *		which are the same as the UTF-16 code units of the protocol
+ *		for the ASCII of Simple C.  We keep the offset of the start
+ *		of each line of a document, so that finding a position
+ *		doesn't mean counting lines from the start of the text.
+ *
+ *		If asked to, every message received is recorded in a file,
+ *		just as it was read, so that the session can be replayed. *
+ *		A document is first analyzed just as when checking in
+ *		parallel, except that the bodies are then checked in turn.
+ *		The analysis is kept, and an edit that falls within a single
+ *		function body only reads and checks that body again,
+ *		against the same snapshot of the outermost scope, which the
+ *		edit can't have changed.  Any other edit means analyzing the
+ *		whole document again.  The diagnostics are those of the
+ *		segments up to the first that failed, as when checking in
+ *		parallel, so they are just what checking the text would
+ *		report.
+ */
+
+# include <algorithm>
+# include <cctype>
+# include <climits>
+# include <cstdio>
+# include <cstdlib>
+# include <cstring>
+# include <iostream>
+# include <map>
+# include <sstream>
+# include <strings.h>
+# include "lsp.h"
+# include "parser.h"
+# include "tokens.h"
+# include "trace.h"
+
+using namespace std;
+
+static const unsigned deepest = 256;
+static const long longest = 1 << 26;
+
+namespace {
+    struct Json {
+	enum Kind { NONE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+	Kind kind = NONE;
+	bool truth = false;
+	double number = 0;
+	string text;
+	vector<string> keys;
+	vector<Json> values;
+
+	const Json &operator [](const char *key) const;
+    };
+
+    struct Document {
+	string text;
+	vector<unsigned> lines;
+	long version;
+    };
+
+    struct Function {
+	Body body;
+	unsigned open, close;
+	int line;
+	Buffer *tokens;
+    };
+}
+
+static string document;
+static Buffer *whole;
+static vector<Function> functions;
+static Split split;
+
+
+/*
+ * Function:	Json::operator []
+ *
+ * Description:	Return the member of this object with the given KEY, or
+ *		a value of no kind if there is none.
+ */
+
+const Json &Json::operator [](const char *key) const
+{
+    static const Json none;
+
+
+    for (unsigned i = 0; i < keys.size(); i ++)
+	if (keys[i] == key)
+	    return values[i];
+
+    return none;
+}
+
+
+/*
+ * Function:	skip
+ *
+ * Description:	Return P moved past any white space.
+ */
+
+static const char *skip(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+	p ++;
+
+    return p;
+}
+
+
+/*
+ * Function:	encode
+ *
+ * Description:	Append a code point to a string in UTF-8.
+ */
+
+static void encode(string &s, unsigned long c)
+{
+    if (c < 0x80)
+	s += (char) c;
+    else if (c < 0x800) {
+	s += (char) (0xc0 | c >> 6);
+	s += (char) (0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+	s += (char) (0xe0 | c >> 12);
+	s += (char) (0x80 | (c >> 6 & 0x3f));
+	s += (char) (0x80 | (c & 0x3f));
+    } else {
+	s += (char) (0xf0 | c >> 18);
+	s += (char) (0x80 | (c >> 12 & 0x3f));
+	s += (char) (0x80 | (c >> 6 & 0x3f));
+	s += (char) (0x80 | (c & 0x3f));
+    }
+}
+
+
+/*
+ * Function:	hex
+ *
+ * Description:	Read four hexadecimal digits at P into C, and return
+ *		whether there were four.
+ */
+
+static bool hex(const char *&p, unsigned long &c)
+{
+    char digits[5];
+    char *end;
+
+
+    strncpy(digits, p, 4);
+    digits[4] = '\0';
+    c = strtoul(digits, &end, 16);
+
+    if (end != digits + 4 || !isxdigit((unsigned char) digits[0]))
+	return false;
+
+    p += 4;
+    return true;
+}
+
+
+/*
+ * Function:	readString
+ *
+ * Description:	Read a JSON string literal at P, just past its opening
+ *		quote, into S, and return whether it was well formed.  The
+ *		runs of characters without escapes are copied whole, since
+ *		the text of a document may be long.
+ */
+
+static bool readString(const char *&p, string &s)
+{
+    unsigned long c, low;
+    const char *start;
+
+
+    while (true) {
+	for (start = p; *p != '"' && *p != '\\' && *p != '\0'; p ++)
+	    continue;
+
+	s.append(start, p - start);
+
+	if (*p == '"') {
+	    p ++;
+	    return true;
+	}
+
+	if (*p == '\0' || *++ p == '\0')
+	    return false;
+
+	switch (*p ++) {
+	case '"': s += '"'; break;
+	case '\\': s += '\\'; break;
+	case '/': s += '/'; break;
+	case 'b': s += '\b'; break;
+	case 'f': s += '\f'; break;
+	case 'n': s += '\n'; break;
+	case 'r': s += '\r'; break;
+	case 't': s += '\t'; break;
+
+	case 'u':
+	    if (!hex(p, c))
+		return false;
+
+	    if (c >= 0xd800 && c < 0xdc00 && p[0] == '\\' && p[1] == 'u') {
+		p += 2;
+
+		if (!hex(p, low) || low < 0xdc00 || low >= 0xe000)
+		    return false;
+
+		c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+	    }
+
+	    encode(s, c);
+	    break;
+
+	default:
+	    return false;
+	}
+    }
+}
+
+
+/*
+ * Function:	readValue
+ *
+ * Description:	Read a JSON value at P into VALUE, and return whether it
+ *		was well formed.  Values nested too deeply are refused.
+ */
+
+static bool readValue(const char *&p, Json &value, unsigned depth)
+{
+    char *end;
+
+
+    p = skip(p);
+
+    if (depth > deepest)
+	return false;
+
+    if (*p == '{') {
+	value.kind = Json::OBJECT;
+	p = skip(p + 1);
+
+	if (*p == '}') {
+	    p ++;
+	    return true;
+	}
+
+	while (true) {
+	    value.keys.push_back(string());
+	    value.values.push_back(Json());
+
+	    if (*p != '"' || !readString(++ p, value.keys.back()))
+		return false;
+
+	    if (*(p = skip(p)) != ':')
+		return false;
+
+	    if (!readValue(++ p, value.values.back(), depth + 1))
+		return false;
+
+	    p = skip(p);
+
+	    if (*p == '}') {
+		p ++;
+		return true;
+	    }
+
+	    if (*p != ',')
+		return false;
+
+	    p = skip(p + 1);
+	}
+
+    } else if (*p == '[') {
+	value.kind = Json::ARRAY;
+	p = skip(p + 1);
+
+	if (*p == ']') {
+	    p ++;
+	    return true;
+	}
+
+	while (true) {
+	    value.values.push_back(Json());
+
+	    if (!readValue(p, value.values.back(), depth + 1))
+		return false;
+
+	    p = skip(p);
+
+	    if (*p == ']') {
+		p ++;
+		return true;
+	    }
+
+	    if (*p ++ != ',')
+		return false;
+	}
+
+    } else if (*p == '"') {
+	value.kind = Json::STRING;
+	return readString(++ p, value.text);
+
+    } else if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+	value.kind = Json::BOOLEAN;
+	value.truth = *p == 't';
+	p += value.truth ? 4 : 5;
+	return true;
+
+    } else if (strncmp(p, "null", 4) == 0) {
+	p += 4;
+	return true;
+    }
+
+    value.kind = Json::NUMBER;
+    value.number = strtod(p, &end);
+
+    if (end == p)
+	return false;
+
+    p = end;
+    return true;
+}
+
+
+/*
+ * Function:	length
+ *
+ * Description:	Return the length given by a Content-Length header, or -1
+ *		if it isn't a number or is too large to be a length.
+ */
+
+static long length(const char *p)
+{
+    long n = 0;
+
+
+    while (*p == ' ' || *p == '\t')
+	p ++;
+
+    if (!isdigit((unsigned char) *p))
+	return -1;
+
+    while (isdigit((unsigned char) *p)) {
+	if (n > (LONG_MAX - 9) / 10)
+	    return -1;
+
+	n = n * 10 + (*p ++ - '0');
+    }
+
+    while (isspace((unsigned char) *p))
+	p ++;
+
+    return *p == '\0' ? n : -1;
+}
+
+
+/*
+ * Function:	receive
+ *
+ * Description:	Read the next message from the standard input into BODY,
+ *		recording it in the given file if there is one, and return
+ *		whether there was one.  A message too long to hold is
+ *		skipped, and one whose header lacks a length is taken to
+ *		have no body.  Either way the body is left empty, so the
+ *		message is refused like any other that isn't JSON, rather
+ *		than ending the session.
+ */
+
+static bool receive(string &body, FILE *record)
+{
+    char line[1024], skipped[4096];
+    long size = -1, n;
+
+
+    body.clear();
+
+    while (fgets(line, sizeof(line), stdin) != nullptr) {
+	if (strcmp(line, "\r\n") == 0 || strcmp(line, "\n") == 0) {
+	    if (size < 0)
+		return true;
+
+	    if (size > longest) {
+		for (; size > 0; size -= n)
+		    if ((n = fread(skipped, 1, min(size, (long) sizeof(skipped)), stdin)) == 0)
+			return false;
+
+		return true;
+	    }
+
+	    body.resize(size);
+
+	    if (fread(&body[0], 1, size, stdin) != (size_t) size)
+		return false;
+
+	    if (record != nullptr) {
+		fprintf(record, "Content-Length: %ld\r\n\r\n", size);
+		fwrite(body.data(), 1, size, record);
+		fflush(record);
+	    }
+
+	    return true;
+	}
+
+	if (strncasecmp(line, "Content-Length:", 15) == 0)
+	    size = length(line + 15);
+    }
+
+    return false;
+}
+
+
+/*
+ * Function:	send
+ *
+ * Description:	Write a message with the given body to the standard output.
+ */
+
+static void send(const string &body)
+{
+    cout << "Content-Length: " << body.size() << "\r\n\r\n" << body << flush;
+}
+
+
+/*
+ * Function:	writeId
+ *
+ * Description:	Write the id of a request, which is either a number or a
+ *		string.
+ */
+
+static void writeId(ostream &ostr, const Json &id)
+{
+    char buf[32];
+
+
+    if (id.kind == Json::STRING)
+	Diagnostics::escape(ostr, id.text);
+
+    else if (id.kind == Json::NUMBER) {
+	snprintf(buf, sizeof(buf), "%.17g", id.number);
+	ostr << buf;
+
+    } else
+	ostr << "null";
+}
+
+
+/*
+ * Function:	respond
+ *
+ * Description:	Send the given result of the request with the given id.
+ */
+
+static void respond(const Json &id, const string &result)
+{
+    ostringstream body;
+
+
+    body << "{\"jsonrpc\": \"2.0\", \"id\": ";
+    writeId(body, id);
+    body << ", \"result\": " << result << "}";
+    send(body.str());
+}
+
+
+/*
+ * Function:	refuse
+ *
+ * Description:	Send the given error for the request with the given id.
+ */
+
+static void refuse(const Json &id, int code, const string &message)
+{
+    ostringstream body;
+
+
+    body << "{\"jsonrpc\": \"2.0\", \"id\": ";
+    writeId(body, id);
+    body << ", \"error\": {\"code\": " << code << ", \"message\": ";
+    Diagnostics::escape(body, message);
+    body << "}}";
+    send(body.str());
+}
+
+
+/*
+ * Function:	publish
+ *
+ * Description:	Send the diagnostics found in a document.
+ */
+
+static void publish(const string &uri, const Document *document,
+	const vector<Diagnostic> &found)
+{
+    const char *separator = "";
+    ostringstream body;
+    int line;
+
+
+    body << "{\"jsonrpc\": \"2.0\", \"method\": \"textDocument/publishDiagnostics\",";
+    body << " \"params\": {\"uri\": ";
+    Diagnostics::escape(body, uri);
+
+    if (document != nullptr)
+	body << ", \"version\": " << document->version;
+
+    body << ", \"diagnostics\": [";
+
+    for (auto &diagnostic : found) {
+	line = max(diagnostic.line - 1, 0);
+	body << separator << "{\"range\": {\"start\": {\"line\": " << line;
+	body << ", \"character\": 0}, \"end\": {\"line\": " << line + 1;
+	body << ", \"character\": 0}}, \"severity\": 1, \"code\": \"";
+	body << Diagnostics::rule(diagnostic.id) << "\", \"source\": \"scc\"";
+	body << ", \"message\": ";
+	Diagnostics::escape(body, Diagnostics::message(diagnostic));
+	body << "}";
+	separator = ", ";
+    }
+
+    body << "]}}";
+    send(body.str());
+}
+
+
+/*
+ * Function:	index
+ *
+ * Description:	Find the start of each line of the text of a document.
+ */
+
+static void index(Document &document)
+{
+    const string &text = document.text;
+
+
+    document.lines.assign(1, 0);
+
+    for (size_t i = text.find('\n'); i != string::npos; i = text.find('\n', i + 1))
+	document.lines.push_back(i + 1);
+}
+
+
+/*
+ * Function:	position
+ *
+ * Description:	Return the offset in the text of a document of the given
+ *		position, which is kept within the text and its line.
+ */
+
+static unsigned position(const Document &document, const Json &position)
+{
+    long line, character;
+    unsigned start, end;
+
+
+    line = (long) position["line"].number;
+    character = (long) position["character"].number;
+
+    if (line < 0)
+	return 0;
+
+    if (line >= (long) document.lines.size())
+	return document.text.size();
+
+    start = document.lines[line];
+
+    if (line + 1 < (long) document.lines.size())
+	end = document.lines[line + 1] - 1;
+    else
+	end = document.text.size();
+
+    return character <= 0 ? start : min(start + (unsigned long) character, (unsigned long) end);
+}
+
+
+/*
+ * Function:	replace
+ *
+ * Description:	Replace the given number of bytes at START in the text of a
+ *		document with the given TEXT, updating the starts of its
+ *		lines, and return the edit made.
+ */
+
+static Edit replace(Document &document, unsigned start, unsigned removed,
+	const string &text)
+{
+    vector<unsigned> added;
+    int delta = text.size() - removed;
+    Edit edit = {start, removed, (unsigned) text.size(), 0};
+
+
+    for (size_t i = text.find('\n'); i != string::npos; i = text.find('\n', i + 1))
+	added.push_back(start + i + 1);
+
+    auto first = upper_bound(document.lines.begin(), document.lines.end(), start);
+    auto last = upper_bound(first, document.lines.end(), start + removed);
+
+    for (auto it = last; it != document.lines.end(); it ++)
+	*it += delta;
+
+    edit.lines = added.size() - (last - first);
+    first = document.lines.erase(first, last);
+    document.lines.insert(first, added.begin(), added.end());
+    document.text.replace(start, removed, text);
+    return edit;
+}
+
+
+/*
+ * Function:	rewrite
+ *
+ * Description:	Replace the whole text of a document, and return the edit
+ *		made, which is the part between what the old and new texts
+ *		start and end with.
+ */
+
+static Edit rewrite(Document &document, const string &text)
+{
+    const string &old = document.text;
+    unsigned prefix = 0, suffix = 0, limit;
+    int lines;
+    Edit edit;
+
+
+    limit = min(old.size(), text.size());
+
+    while (prefix < limit && old[prefix] == text[prefix])
+	prefix ++;
+
+    while (suffix < limit - prefix &&
+	    old[old.size() - suffix - 1] == text[text.size() - suffix - 1])
+	suffix ++;
+
+    edit.start = prefix;
+    edit.removed = old.size() - prefix - suffix;
+    edit.inserted = text.size() - prefix - suffix;
+
+    lines = document.lines.size();
+    document.text = text;
+    index(document);
+
+    edit.lines = (int) document.lines.size() - lines;
+    return edit;
+}
+
+
+/*
+ * Function:	speak
+ *
+ * Description:	Speak the Language Server Protocol over the standard input
+ *		and output, analyzing documents with the given function,
+ *		and recording what we receive in a file if one is named.
+ *		Return the exit status, which is a failure unless we were
+ *		shut down before being told to exit.
+ */
+
+int speak(Analyzer analyze, const char *record)
+{
+    map<string, Document> documents;
+    vector<Diagnostic> found;
+    bool shutdown = false;
+    FILE *file = nullptr;
+    string body;
+    Edit edit;
+
+
+    if (record != nullptr && (file = fopen(record, "wb")) == nullptr) {
+	cerr << "scc: cannot write " << record << endl;
+	return EXIT_FAILURE;
+    }
+
+    while (receive(body, file)) {
+	Json message;
+	const char *p = body.c_str();
+
+	if (!readValue(p, message, 0) || message.kind != Json::OBJECT) {
+	    refuse(Json(), -32700, "parse error");
+	    continue;
+	}
+
+	const string &method = message["method"].text;
+	const Json &id = message["id"];
+	const Json &params = message["params"];
+	const string &uri = params["textDocument"]["uri"].text;
+
+	if (method == "initialize") {
+	    respond(id, "{\"capabilities\": {\"textDocumentSync\":"
+		    " {\"openClose\": true, \"change\": 2}},"
+		    " \"serverInfo\": {\"name\": \"scc\"}}");
+
+	} else if (method == "shutdown") {
+	    shutdown = true;
+	    respond(id, "null");
+
+	} else if (method == "exit")
+	    break;
+
+	else if (method == "textDocument/didOpen") {
+	    Document &document = documents[uri];
+
+	    document.text = params["textDocument"]["text"].text;
+	    document.version = (long) params["textDocument"]["version"].number;
+	    index(document);
+	    analyze(uri, &document.text, nullptr, found);
+	    publish(uri, &document, found);
+
+	} else if (method == "textDocument/didChange") {
+	    auto it = documents.find(uri);
+
+	    if (it == documents.end())
+		continue;
+
+	    Document &document = it->second;
+	    document.version = (long) params["textDocument"]["version"].number;
+
+	    for (auto &change : params["contentChanges"].values) {
+		const Json &range = change["range"];
+
+		if (range.kind == Json::OBJECT) {
+		    unsigned start = position(document, range["start"]);
+		    unsigned end = position(document, range["end"]);
+
+		    edit = replace(document, start, max(start, end) - start, change["text"].text);
+		} else
+		    edit = rewrite(document, change["text"].text);
+
+		analyze(uri, &document.text, &edit, found);
+	    }
+
+	    publish(uri, &document, found);
+
+	} else if (method == "textDocument/didClose") {
+	    documents.erase(uri);
+	    analyze(uri, nullptr, nullptr, found);
+	    publish(uri, nullptr, vector<Diagnostic>());
+
+	} else if (id.kind != Json::NONE && !method.empty())
+	    refuse(id, -32601, "unknown method " + method);
+    }
+
+    if (file != nullptr)
+	fclose(file);
+
+    return shutdown ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*
+ * Function:	forget
+ *
+ * Description:	Forget the document being edited, releasing its scopes.
+ */
+
+static void forget()
+{
+    for (auto &f : functions)
+	delete f.tokens;
+
+    functions.clear();
+    delete whole;
+    whole = nullptr;
+    document.clear();
+    releaseUnit(split);
+}
+
+
+/*
+ * Function:	recheck
+ *
+ * Description:	Check a function body of the document being edited from
+ *		its own tokens if it has been edited, or else from those of
+ *		the document, replacing its output and diagnostics.
+ */
+
+static void recheck(Function &f)
+{
+    if (f.tokens != nullptr)
+	checkBody(split, f.body, *f.tokens, 0, f.tokens->size() - 1);
+    else
+	checkBody(split, f.body, *whole, f.body.begin, f.body.end);
+}
+
+
+/*
+ * Function:	survey
+ *
+ * Description:	Analyze all of the text of a document, just as when
+ *		checking in parallel, but with every function body then
+ *		checked in turn on this thread.  The braces of each body
+ *		are found, so that an edit can be matched with its body.
+ *		A body that isn't closed can't be.
+ */
+
+static void survey(const string &uri, const string &text)
+{
+    forget();
+    document = uri;
+    whole = new Buffer();
+    whole->scan(text);
+    splitUnit(split, *whole);
+
+    for (auto &body : split.bodies) {
+	const Token &first = (*whole)[body.begin], &last = (*whole)[body.end - 1];
+	Function f = {body, first.offset, first.offset, first.line, nullptr};
+
+	if (last.kind == '}' && body.end - 1 > body.begin)
+	    f.close = last.offset;
+
+	functions.push_back(f);
+    }
+
+    split.bodies.clear();
+
+    for (auto &f : functions)
+	recheck(f);
+}
+
+
+/*
+ * Function:	alone
+ *
+ * Description:	Return whether the quote at the given offset is followed
+ *		by nothing but plain characters up to the end of its line,
+ *		which comes before the given end.
+ */
+
+static bool alone(const string &text, unsigned start, unsigned end)
+{
+    size_t i = text.find_first_of("\n{}\"'/\\", start + 1);
+
+
+    return i < end && text[i] == '\n';
+}
+
+
+/*
+ * Function:	revise
+ *
+ * Description:	Check a document again after an edit that lies within a
+ *		single function body, without touching its braces, and
+ *		return whether we could.  Only that body is read and
+ *		checked again, against the same snapshot of the outermost
+ *		scope, since nothing else has changed.  Everything after it
+ *		is simply moved by the size of the edit.
+ *
+ *		The body must still be balanced, closing only at its last
+ *		brace, and reading it on its own must give the same tokens
+ *		as reading the whole text would.  That is so unless a quote
+ *		without its mate was read, which might be closed after the
+ *		body, or hide a brace or comment when the body is skipped,
+ *		so we only go on if the rest of its line is harmless.
+ */
+
+static bool revise(const string &text, const Edit &edit)
+{
+    unsigned i, end = edit.start + edit.removed;
+    int delta = edit.inserted - edit.removed, depth = 0;
+    bool balanced = true, reached = false;
+    Buffer *tokens;
+
+
+    auto it = upper_bound(functions.begin(), functions.end(), edit.start,
+	    [](unsigned start, const Function &f) { return start <= f.open; });
+
+    if (it == functions.begin() || end > (-- it)->close)
+	return false;
+
+    Function &f = *it;
+    tokens = new Buffer();
+    tokens->scan(text.substr(f.open, f.close + delta + 1 - f.open), f.line, f.open);
+
+    for (i = 0; i + 1 < tokens->size() && balanced; i ++) {
+	const Token &token = (*tokens)[i];
+
+	if (token.kind == '{')
+	    depth ++;
+	else if (token.kind == '}' && -- depth == 0)
+	    balanced = i + 2 == tokens->size();
+	else if (token.kind == ERROR && (token.text == "\"" || token.text == "'"))
+	    balanced = alone(text, token.offset, f.close + delta);
+    }
+
+    if (!balanced || depth != 0 || (*tokens)[0].kind != '{') {
+	delete tokens;
+	return false;
+    }
+
+    delete f.tokens;
+    f.tokens = tokens;
+    f.close += delta;
+    recheck(f);
+
+    for (auto g = it + 1; g != functions.end(); g ++) {
+	g->open += delta;
+	g->close += delta;
+	g->line += edit.lines;
+    }
+
+    if (edit.lines != 0)
+	for (auto segment : split.segments) {
+	    if (reached)
+		segment->diagnostics.shift(edit.lines);
+
+	    reached = reached || segment == f.body.segment;
+	}
+
+    return true;
+}
+
+
+/*
+ * Function:	analyze
+ *
+ * Description:	Analyze a document that was opened or edited, filling in
+ *		the diagnostics found, which are the ones the compiler would
+ *		report for its text.  Only the document being edited has
+ *		its analysis kept, so an edit to another one, or one we
+ *		can't match with a body, means analyzing all of it.  A
+ *		missing text means the document was closed.
+ */
+
+static void analyze(const string &uri, const string *text, const Edit *edit,
+	vector<Diagnostic> &found)
+{
+    vector<const Diagnostics *> logs;
+    bool truncated;
+
+
+    found.clear();
+
+    if (text == nullptr) {
+	if (uri == document)
+	    forget();
+
+	return;
+    }
+
+    if (uri != document || edit == nullptr)
+	survey(uri, *text);
+    else if (edit->removed > 0 || edit->inserted > 0)
+	if (!revise(*text, *edit))
+	    survey(uri, *text);
+
+    for (auto segment : split.segments) {
+	logs.push_back(&segment->diagnostics);
+
+	if (segment->failed)
+	    break;
+    }
+
+    for (auto diagnostic : Diagnostics::collect(logs, truncated))
+	found.push_back(*diagnostic);
+}
+
+
+/*
+ * Function:	edit
+ *
+ * Description:	Serve an editor over the Language Server Protocol, and
+ *		return the exit status.  A prelude is read once first, so
+ *		that one that can't be read is reported right away.
+ */
+
+int edit(const char *record)
+{
+    ostream discard(nullptr);
+    int status;
+
+
+    output = &discard;
+    checkPrelude();
+    status = speak(analyze, record);
+    forget();
+    return status;
+}
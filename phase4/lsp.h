@@ -0,0 +1,35 @@
+/*
+ * File:	lsp.h
+ *
+ * Description:	This file contains the declarations for speaking the
+ *		Language Server Protocol over the standard input and output
+ *		in Simple C, so that an editor can show the diagnostics of
+ *		each open document as it is being edited.
+ *
+ *		The protocol is handled apart from checking the documents,
+ *		which is done by an analyzer that is told about each
+ *		document opened, each edit made to it, and each document
+ *		closed, and gives back the diagnostics of the document as
+ *		it now is.  Editing uses an analyzer built on the parser,
+ *		which checks again only the function body that was edited.
+ */
+
+# ifndef LSP_H
+# define LSP_H
+# include <string>
+# include <vector>
+# include "Diagnostics.h"
+
+struct Edit {
+    unsigned start;
+    unsigned removed, inserted;
+    int lines;
+};
+
+typedef void (*Analyzer)(const std::string &uri, const std::string *text,
+	const Edit *edit, std::vector<Diagnostic> &found);
+
+int speak(Analyzer analyze, const char *record);
+int edit(const char *record);
+
+# endif /* LSP_H */
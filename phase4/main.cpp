@@ -0,0 +1,21 @@
+/*
+ * File:	main.cpp
+ *
+ * Description:	This file contains the main function for the compiler for
+ *		Simple C.  Everything else is in the library, so that other
+ *		programs can check sources too.
+ */
+
+# include "driver.h"
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Run the compiler with our arguments.
+ */
+
+int main(int argc, char *argv[])
+{
+    return command(argc, argv);
+}
@@ -4,18 +4,75 @@
  * Description:	This file contains the public and private function and
  *		variable definitions for the recursive-descent parser for
  *		Simple C.
+ *
+ *		Extra functionality:
+ *		- checking function bodies in parallel, or deferring them
+ *		  to be checked later
+ *		- skipping function bodies when skimming
+ *		- stopping after a number of errors, in source order
+ *		- writing the frame slots of locals and their uses
+ *		- writing the values of constant expressions
+ *		- starting from the globals of a prelude
+ *
+ *		When checking in parallel, the whole input is first read
+ *		into a buffer.  The parser then makes a first pass that
+ *		declares the globals and function signatures, skipping each
+ *		function body by matching braces.  The bodies are then
+ *		checked on a pool of threads, each against a snapshot of
+ *		the outermost scope as it was at the body's definition.
+ *		All output and diagnostics are collected into segments,
+ *		one per body and one per stretch of globals between them,
+ *		which are written in source order once everything is done.
+ *
+ *		The limit on errors applies to the diagnostics in source
+ *		order, which is not the order in which the threads report
+ *		them.  A body is given up once the diagnostics known to
+ *		come before or in it pass the limit.  These are the ones
+ *		from the first pass that come before the body, the ones in
+ *		the bodies before the first one that is still unchecked,
+ *		and the ones in the body itself.
+ *
+ *		When skimming, function bodies are skipped by the lexer
+ *		without being broken into tokens, and nothing but the
+ *		signatures in the outermost scope is written.
  */
 
+# include <atomic>
 # include <cstdlib>
 # include <iostream>
+# include <mutex>
+# include <sstream>
 # include "checker.h"
+# include "string.h"
+# include "Layout.h"
+# include "trace.h"
 # include "tokens.h"
 # include "lexer.h"
+# include "Buffer.h"
+# include "stats.h"
+# include "timing.h"
+# include "prelude.h"
+# include "parser.h"
 
 using namespace std;
 
-static int lookahead;
-static string lexbuf;
+class SyntaxError {};
+
+static thread_local int lookahead;
+static thread_local string lexbuf;
+
+static thread_local const Buffer *buffer;
+static thread_local unsigned cursor, limit;
+static thread_local int line;
+
+static thread_local bool skimming, splitting;
+static thread_local string function;
+
+Diagnostics standard;
+static thread_local Split *unit;
+static thread_local Body *current;
+Options defaults;
+static thread_local const Options *options = &defaults;
 
 // string E1 =  "invalid return type";
 // string E2 = "invalid type for test expression";
@@ -27,15 +84,59 @@ static string lexbuf;
 
 
 
-static Type expression(bool &lvalue);
+static Type expression(bool &lvalue, Constant &value);
 static void statement(const Type &returnType);
 
 
+/*
+ * Function:	finish
+ *
+ * Description:	Write the diagnostics reported when not checking in
+ *		parallel, and return the given exit status.
+ */
+
+int finish(int status)
+{
+    PhaseTimer timer(Phase::OUTPUT);
+
+
+    Diagnostics::render(cerr, {&standard});
+    return status;
+}
+
+
+
+/*
+ * Function:	seed
+ *
+ * Description:	Open the outermost scope, declaring the symbols of the
+ *		prelude if one was given, and return the scope.  If we are
+ *		parsing from a buffer, a prelude that can't be read is left
+ *		to the caller.
+ */
+
+static Scope *seed()
+{
+    Scope *globals = openScope();
+
+    if (options->prelude != nullptr && !readPrelude(options->prelude, globals)) {
+	if (buffer != nullptr)
+	    throw PreludeError();
+
+	cerr << "scc: cannot read prelude " << options->prelude << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    return globals;
+}
+
 
 /*
  * Function:	error
  *
- * Description:	Report a syntax error to standard error.
+ * Description:	Report a syntax error to standard error.  If we are
+ *		parsing from a buffer, other threads may still be running,
+ *		so we leave it to the caller to stop.
  */
 
 static void error()
@@ -45,7 +146,122 @@ static void error()
     else
 	report("syntax error at '%s'", lexbuf);
 
-    exit(EXIT_FAILURE);
+    if (buffer != nullptr)
+	throw SyntaxError();
+
+    exit(finish(EXIT_FAILURE));
+}
+
+
+/*
+ * Function:	slotted
+ *
+ * Description:	Return SYMBOL, which was just declared or used, first
+ *		writing where it lives if we are dumping slots.  A local
+ *		or parameter lives in a slot of the frame of the current
+ *		function.
+ */
+
+static Symbol *slotted(Symbol *symbol, bool declared)
+{
+    if (options->dumping) {
+	*output << "line " << *location << ": " << symbol->name();
+	*output << (declared ? " := " : " -> ");
+
+	if (symbol->type().isError())
+	    *output << "error\n";
+	else if (symbol->slot() < 0)
+	    *output << "global\n";
+	else
+	    *output << function << "[" << symbol->slot() << "]\n";
+    }
+
+    return symbol;
+}
+
+
+/*
+ * Function:	exhausted
+ *
+ * Description:	Return whether more errors than the limit are known to
+ *		come before the current point in the input.  We go on past
+ *		the limit by one error, so that whoever renders them knows
+ *		that one was dropped and the output was truncated.
+ */
+
+static bool exhausted()
+{
+    unsigned limit = Diagnostics::limit(), count = diagnostics->size();
+
+
+    if (limit == 0)
+	return false;
+
+    if (unit != nullptr) {
+	if (current == nullptr)
+	    count += unit->passed;
+	else
+	    count += current->before + unit->settled;
+    }
+
+    return count > limit;
+}
+
+
+/*
+ * Function:	checkLimit
+ *
+ * Description:	Stop once we've passed the limit on errors.  As with a
+ *		syntax error, if we are parsing from a buffer, we leave it
+ *		to the caller to stop.
+ */
+
+static void checkLimit()
+{
+    if (!exhausted())
+	return;
+
+    if (buffer != nullptr)
+	throw SyntaxError();
+
+    exit(finish(EXIT_FAILURE));
+}
+
+
+/*
+ * Function:	advance
+ *
+ * Description:	Read the next token into the lookahead.  If we are parsing
+ *		from a buffer, any diagnostics the lexer reported for the
+ *		token are replayed now, and reading past the end of the
+ *		current range of tokens yields the end of file.
+ */
+
+static void advance()
+{
+    const Diagnostics *messages;
+
+
+    if (buffer == nullptr) {
+	MemoryTag tag(Memory::TOKENS);
+
+	lookahead = yylex();
+	lexbuf = yytext;
+
+    } else if (cursor < limit) {
+	MemoryTag tag(Memory::TOKENS);
+
+	if ((messages = buffer->messages(cursor)) != nullptr)
+	    diagnostics->append(*messages);
+
+	lookahead = (*buffer)[cursor].kind;
+	lexbuf = (*buffer)[cursor].text;
+	line = (*buffer)[cursor ++].line;
+
+    } else {
+	lookahead = DONE;
+	lexbuf = "";
+    }
 }
 
 
@@ -62,8 +278,7 @@ static void match(int t)
     if (lookahead != t)
 	error();
 
-    lookahead = yylex();
-    lexbuf = yytext;
+    advance();
 }
 
 
@@ -92,6 +307,7 @@ static unsigned long number()
 
 static string identifier()
 {
+    MemoryTag tag(Memory::NAMES);
     string buf;
 
 
@@ -184,10 +400,10 @@ static void declarator(int typespec)
 
     if (lookahead == '[') {
 	match('[');
-	declareVariable(name, Type(typespec, indirection, number()));
+	slotted(declareVariable(name, Type(typespec, indirection, number())), true);
 	match(']');
     } else
-	declareVariable(name, Type(typespec, indirection));
+	slotted(declareVariable(name, Type(typespec, indirection)), true);
 }
 
 
@@ -240,6 +456,22 @@ static void declarations()
 }
 
 
+/*
+ * Function:	addParameter
+ *
+ * Description:	Add the type of a parameter or argument to the end of a
+ *		list of parameters.
+ */
+
+static void addParameter(Parameters &params, const Type &type)
+{
+    MemoryTag tag(Memory::PARAMETERS);
+
+
+    params.push_back(type);
+}
+
+
 /*
  * Function:	primaryExpression
  *
@@ -259,34 +491,38 @@ static void declarations()
  *		  expression , expression-list
  */
 
-static Type primaryExpression(bool &lvalue)
+static Type primaryExpression(bool &lvalue, Constant &value)
 {
     Type left;
+	value = Constant();
 	if (lookahead == '(') {
 	match('(');
-	left = expression(lvalue);
+	left = expression(lvalue, value);
 	match(')');
 	// return left;
 
     } else if (lookahead == CHARACTER) {
+	string chars = parseString(lexbuf.substr(1, lexbuf.length() - 2));
 	match(CHARACTER);
 	left = Type(CHAR);
+	value = target.minimum(CHAR) < 0 ? (signed char) chars[0] : (unsigned char) chars[0];
 	lvalue = false;
 
     } else if (lookahead == STRING) {
-	string id = lexbuf;
+	string chars = parseString(lexbuf.substr(1, lexbuf.length() - 2));
 	match(STRING);
-	left = Type(CHAR, 0, lexbuf.length());
+	left = Type(CHAR, 0, chars.length() + 1);
 	lvalue = false;
 
     } else if (lookahead == NUM) {
-	long temp = stol(lexbuf);
-	match(NUM);				//need to create proper type (int or long) depending on bounds of NUM
+	long temp = strtol(lexbuf.c_str(), NULL, 0);
+	match(NUM);				// an int unless it only fits in a long
 
-	if (temp > INT64_MIN && temp < INT64_MAX)
+	if (target.contains(INT, temp))
 	left = Type(INT);
 	else 
 	left = Type(LONG);
+	value = temp;
 	lvalue = false;
 	
 	
@@ -294,8 +530,8 @@ static Type primaryExpression(bool &lvalue)
     } else if (lookahead == ID) {
 	//lookup ID in symbol table to get type that ID refers too
 	//and check if its declarator is a function.
-		Parameters *params = new Parameters();
-		Symbol *symbol = checkIdentifier(identifier());
+		Parameters params;
+		Symbol *symbol = slotted(checkIdentifier(identifier()), false);
 		left = symbol->type();
 	// if(!(symbol->type().isFunction())) {
 	// 	report("called object is not a function");
@@ -305,17 +541,18 @@ static Type primaryExpression(bool &lvalue)
 		if (lookahead == '(') {
 			match('(');
 			if (lookahead != ')') {
-				Type tmp = expression(lvalue);
-				params->push_back(tmp);
+				Type tmp = expression(lvalue, value);
+				addParameter(params, tmp);
 
 			while (lookahead == ',') {
 				match(',');
-				Type tmp = expression(lvalue);
-				params->push_back(tmp);
+				Type tmp = expression(lvalue, value);
+				addParameter(params, tmp);
 			}
 			}
 			Type func = left;
-			left = checkFunction(func, params);
+			left = checkFunction(func, &params);
+			value = Constant();
 
 			lvalue = false;
 			match(')');
@@ -346,20 +583,21 @@ static Type primaryExpression(bool &lvalue)
  *		  postfix-expression [ expression ]
  */
 
-static Type postfixExpression(bool &lvalue)
+static Type postfixExpression(bool &lvalue, Constant &value)
 {
 
 	//what do we do for expression in the brackets?
 	
-    Type left = primaryExpression(lvalue);
+    Type left = primaryExpression(lvalue, value);
 
     while (lookahead == '[') {
 	match('[');
-	Type right = expression(lvalue);		
+	Type right = expression(lvalue, value);		
 	match(']');
 	left = checkPost(left, right);
+	value = Constant();
 	lvalue = true;
-	cout << "index" << endl;
+	trace::event(Event::INDEX);
 	return left;
     }
 
@@ -381,52 +619,57 @@ static Type postfixExpression(bool &lvalue)
  *		  sizeof prefix-expression
  */
 
-static Type prefixExpression(bool &lvalue)
+static Type prefixExpression(bool &lvalue, Constant &value)
 {
 	Type left;
 	// this is most likely wrong
 	if (lookahead == '!') {
 		match('!');
-		Type right = prefixExpression(lvalue);
+		Type right = prefixExpression(lvalue, value);
 		left = checkNot(right);
-		cout << "not" << endl;
+		value = foldUnary(left, value, '!');
+		trace::event(Event::NOT);
 		lvalue = false;
 		return left;
 
     } else if (lookahead == '-') {
 		match('-');
-		Type right = prefixExpression(lvalue);
-		cout << "neg" << endl;
+		Type right = prefixExpression(lvalue, value);
+		trace::event(Event::NEG);
 		left = checkNeg(right);
+		value = foldUnary(left, value, '-');
 		lvalue = false;
 		return left;
 
     } else if (lookahead == '*') {
 		match('*');
-		Type right = prefixExpression(lvalue);
-		cout << "deref" << endl;
+		Type right = prefixExpression(lvalue, value);
+		trace::event(Event::DEREF);
 		left = checkDeref(right);
+		value = Constant();
 		lvalue = true;
 		return left;
 
     } else if (lookahead == '&') {
 		match('&');
-		Type right = prefixExpression(lvalue);
-		cout << "addr" << endl;
+		Type right = prefixExpression(lvalue, value);
+		trace::event(Event::ADDR);
 		left = checkAddr(right, lvalue);
+		value = Constant();
 		lvalue = false;
 		return left;
 
     } else if (lookahead == SIZEOF) {
 		match(SIZEOF);
-		Type right = prefixExpression(lvalue);
-		cout << "sizeof" << endl;
+		Type right = prefixExpression(lvalue, value);
+		trace::event(Event::SIZEOF);
 		left = checkSizeof(right);
+		value = foldSizeof(left, right);
 		lvalue = false;
 		return left;
 
     } else {
-		left = postfixExpression(lvalue);
+		left = postfixExpression(lvalue, value);
 		return left;
 	}
 }
@@ -446,31 +689,35 @@ static Type prefixExpression(bool &lvalue)
  *		  multiplicative-expression % prefix-expression
  */
 
-static Type multiplicativeExpression(bool &lvalue)
+static Type multiplicativeExpression(bool &lvalue, Constant &value)
 {
-    Type left = prefixExpression(lvalue);
+    Type left = prefixExpression(lvalue, value);
+    Constant operand;
 
     while (1) {
 	if (lookahead == '*') {
 	    match('*');
-	    Type right = prefixExpression(lvalue);
+	    Type right = prefixExpression(lvalue, operand);
 		left = checkMultiplicative(left, right, "*");
+		value = foldBinary(left, value, operand, '*');
 		lvalue = false;
-	    cout << "mul" << endl;
+	    trace::event(Event::MUL);
 
 	} else if (lookahead == '/') {
 	    match('/');
-	    Type right = prefixExpression(lvalue);
-	    cout << "div" << endl;
+	    Type right = prefixExpression(lvalue, operand);
+	    trace::event(Event::DIV);
 		left = checkMultiplicative(left, right, "/");
+		value = foldBinary(left, value, operand, '/');
 		lvalue = false;
 
 	} else if (lookahead == '%') {
 	    match('%');
-	    Type right = prefixExpression(lvalue);
+	    Type right = prefixExpression(lvalue, operand);
 		left = checkMultiplicative(left, right, "%");
+		value = foldBinary(left, value, operand, '%');
 		lvalue = false;
-	    cout << "rem" << endl;
+	    trace::event(Event::REM);
 
 	} else
 	    break;
@@ -491,24 +738,27 @@ static Type multiplicativeExpression(bool &lvalue)
  *		  additive-expression - multiplicative-expression
  */
 
-static Type additiveExpression(bool &lvalue)
+static Type additiveExpression(bool &lvalue, Constant &value)
 {
-    Type left = multiplicativeExpression(lvalue);
+    Type left = multiplicativeExpression(lvalue, value);
+    Constant operand;
 
     while (1) {
 	if (lookahead == '+') {
 	    match('+');
-	    Type right = multiplicativeExpression(lvalue);
+	    Type right = multiplicativeExpression(lvalue, operand);
 		left = checkAdd(left, right);
+		value = foldBinary(left, value, operand, '+');
 		lvalue = false;
-	    cout << "add" << endl;
+	    trace::event(Event::ADD);
 
 	} else if (lookahead == '-') {
 	    match('-');
-	    Type right = multiplicativeExpression(lvalue);
+	    Type right = multiplicativeExpression(lvalue, operand);
 		left = checkSub(left, right);
+		value = foldBinary(left, value, operand, '-');
 		lvalue = false;
-	    cout << "sub" << endl;
+	    trace::event(Event::SUB);
 
 	} else
 	    break;
@@ -533,38 +783,43 @@ static Type additiveExpression(bool &lvalue)
  *		  relational-expression >= additive-expression
  */
 
-static Type relationalExpression(bool &lvalue)
+static Type relationalExpression(bool &lvalue, Constant &value)
 {
-    Type left = additiveExpression(lvalue);
+    Type left = additiveExpression(lvalue, value);
+    Constant operand;
 
     while (1) {
 	if (lookahead == '<') {
 	    match('<');
-	    Type right = additiveExpression(lvalue);
+	    Type right = additiveExpression(lvalue, operand);
 		left = checkRelational(left, right, "<");
+		value = foldBinary(left, value, operand, '<');
 		lvalue = false;
-	    cout << "ltn" << endl;
+	    trace::event(Event::LTN);
 
 	} else if (lookahead == '>') {
 	    match('>');
-	    Type right = additiveExpression(lvalue);
+	    Type right = additiveExpression(lvalue, operand);
 		left = checkRelational(left, right, ">");
+		value = foldBinary(left, value, operand, '>');
 		lvalue = false;
-	    cout << "gtn" << endl;
+	    trace::event(Event::GTN);
 
 	} else if (lookahead == LEQ) {
 	    match(LEQ);
-	    Type right = additiveExpression(lvalue);
+	    Type right = additiveExpression(lvalue, operand);
 		left = checkRelational(left, right, "<=");
+		value = foldBinary(left, value, operand, LEQ);
 		lvalue = false;
-	    cout << "leq" << endl;
+	    trace::event(Event::LEQ);
 
 	} else if (lookahead == GEQ) {
 	    match(GEQ);
-	    Type right = additiveExpression(lvalue);
+	    Type right = additiveExpression(lvalue, operand);
 		left = checkRelational(left, right, ">=");
+		value = foldBinary(left, value, operand, GEQ);
 		lvalue = false;
-	    cout << "geq" << endl;
+	    trace::event(Event::GEQ);
 
 	} else
 	    break;
@@ -585,24 +840,27 @@ static Type relationalExpression(bool &lvalue)
  *		  equality-expression != relational-expression
  */
 
-static Type equalityExpression(bool &lvalue)
+static Type equalityExpression(bool &lvalue, Constant &value)
 {
-    Type left = relationalExpression(lvalue);
+    Type left = relationalExpression(lvalue, value);
+    Constant operand;
 
     while (1) {
 	if (lookahead == EQL) {
 	    match(EQL);
-	    Type right = relationalExpression(lvalue);
+	    Type right = relationalExpression(lvalue, operand);
 		left = checkEquality(left, right, "==");
+		value = foldBinary(left, value, operand, EQL);
 		lvalue = false;
-	    cout << "eql" << endl;
+	    trace::event(Event::EQL);
 
 	} else if (lookahead == NEQ) {
 	    match(NEQ);
-	    Type right = relationalExpression(lvalue);
+	    Type right = relationalExpression(lvalue, operand);
 		left = checkRelational(left, right, "!=");
+		value = foldBinary(left, value, operand, NEQ);
 		lvalue = false;
-	    cout << "neq" << endl;
+	    trace::event(Event::NEQ);
 
 	} else
 	    break;
@@ -622,16 +880,18 @@ static Type equalityExpression(bool &lvalue)
  *		  logical-and-expression && equality-expression
  */
 
-static Type logicalAndExpression(bool &lvalue)
+static Type logicalAndExpression(bool &lvalue, Constant &value)
 {
-    Type left = equalityExpression(lvalue);
+    Type left = equalityExpression(lvalue, value);
+    Constant operand;
 
     while (lookahead == AND) {
 	match(AND);
-	Type right = equalityExpression(lvalue);
+	Type right = equalityExpression(lvalue, operand);
 	left = checkLogical(left, right, "&&");
+	value = foldBinary(left, value, operand, AND);
 	lvalue = false;
-	cout << "and" << endl;
+	trace::event(Event::AND);
     }
 
 	return left;
@@ -650,21 +910,44 @@ static Type logicalAndExpression(bool &lvalue)
  *		  expression || logical-and-expression
  */
 
-static Type expression(bool &lvalue)
+static Type expression(bool &lvalue, Constant &value)
 {
-    Type left = logicalAndExpression(lvalue);
+    Type left = logicalAndExpression(lvalue, value);
+    Constant operand;
 
     while (lookahead == OR) {
 	match(OR);
-	Type right = logicalAndExpression(lvalue);
+	Type right = logicalAndExpression(lvalue, operand);
 	left = checkLogical(left, right, "||");
+	value = foldBinary(left, value, operand, OR);
 	lvalue = false;
-	cout << "or" << endl;
+	trace::event(Event::OR);
     }
 	return left;
 }
 
 
+/*
+ * Function:	fullExpression
+ *
+ * Description:	Parse an expression that isn't part of another, writing
+ *		its value if it is known and we are writing constants.
+ */
+
+static Type fullExpression(bool &lvalue)
+{
+    int first = *location;
+    Constant value;
+    Type left = expression(lvalue, value);
+
+
+    if (options->folding && value.known())
+	*output << "line " << first << ": constant " << value.value() << "\n";
+
+    return left;
+}
+
+
 /*
  * Function:	statements
  *
@@ -697,11 +980,11 @@ static void statements(const Type &returnType)
 
 static void assignment(bool &lvalue)
 {
-    Type left = expression(lvalue);
+    Type left = fullExpression(lvalue);
 	bool temp_lval = lvalue;
     if (lookahead == '=') {
 	match('=');
-	Type right = expression(lvalue);
+	Type right = fullExpression(lvalue);
 	checkAssignment(left, right, temp_lval);
     }
 }
@@ -727,6 +1010,9 @@ static void statement(const Type &returnType)
 {
 	Type left;
 	bool lvalue = false; // PLACEHOLDER
+
+    checkLimit();
+
     if (lookahead == '{') {
 		match('{');
 		openScope();
@@ -737,14 +1023,14 @@ static void statement(const Type &returnType)
 
     } else if (lookahead == RETURN) {
 		match(RETURN);
-		left = expression(lvalue);
+		left = fullExpression(lvalue);
 		checkReturn(returnType, left);
 		match(';');
 
     } else if (lookahead == WHILE) {
 		match(WHILE);
 		match('(');
-		left = expression(lvalue);
+		left = fullExpression(lvalue);
 		left = checkWhile(left);
 		match(')');
 		statement(returnType);
@@ -754,7 +1040,7 @@ static void statement(const Type &returnType)
 		match('(');
 		assignment(lvalue);
 		match(';');
-		left = expression(lvalue);
+		left = fullExpression(lvalue);
 		left = checkFor(left);
 		match(';');
 		assignment(lvalue);
@@ -764,7 +1050,7 @@ static void statement(const Type &returnType)
     } else if (lookahead == IF) {
 		match(IF);
 		match('(');
-		left = expression(lvalue);
+		left = fullExpression(lvalue);
 		left = checkIf(left);
 		match(')');
 		statement(returnType);
@@ -804,7 +1090,7 @@ static Type parameter()
     name = identifier();
 
     type = Type(typespec, indirection);
-    declareVariable(name, type);
+    slotted(declareVariable(name, type), true);
     return type;
 }
 
@@ -826,17 +1112,15 @@ static Type parameter()
  *		  , parameter remaining-parameters
  */
 
-static Parameters *parameters()
+static Parameters parameters()
 {
     int typespec;
     unsigned indirection;
-    Parameters *params;
+    Parameters params;
     string name;
     Type type;
 
 
-    params = new Parameters();
-
     if (lookahead == VOID) {
 	typespec = VOID;
 	match(VOID);
@@ -851,18 +1135,130 @@ static Parameters *parameters()
     name = identifier();
 
     type = Type(typespec, indirection);
-    declareVariable(name, type);
-    params->push_back(type);
+    slotted(declareVariable(name, type), true);
+    addParameter(params, type);
 
     while (lookahead == ',') {
 	match(',');
-	params->push_back(parameter());
+	addParameter(params, parameter());
     }
 
     return params;
 }
 
 
+/*
+ * Function:	functionBody
+ *
+ * Description:	Parse the body of a function whose scope is the top-level
+ *		scope, and close that scope.
+ *
+ *		function-body:
+ *		  { declarations statements }
+ */
+
+static void functionBody(const Type &returnType)
+{
+    SpanTimer span("function", function);
+
+
+    match('{');
+    declarations();
+    statements(returnType);
+    closeScope();
+
+    if (options->dumping)
+	*output << function << ": " << frameSize() << " slots\n";
+
+    match('}');
+}
+
+
+/*
+ * Function:	newSegment
+ *
+ * Description:	Start a new segment and direct all output and diagnostics
+ *		of the calling thread to it.
+ */
+
+static Segment *newSegment()
+{
+    Segment *segment = new Segment();
+
+    unit->passed += diagnostics->size();
+    unit->segments.push_back(segment);
+    output = &segment->output;
+    diagnostics = &segment->diagnostics;
+    return segment;
+}
+
+
+/*
+ * Function:	deferBody
+ *
+ * Description:	Skip the body of a function whose scope is the top-level
+ *		scope by matching braces, and remember it to be checked
+ *		later, along with the first token of its definition.
+ *		Anything after the body goes into a new segment.
+ */
+
+static void deferBody(const Type &returnType, unsigned first)
+{
+    unsigned depth;
+    Body body;
+
+
+    if (lookahead != '{')
+	error();
+
+    body.scope = closeScope();
+    body.returnType = returnType;
+    body.snapshot = snapshotScope();
+    body.before = unit->passed + diagnostics->size();
+    body.checked = body.replayed = false;
+    body.function = function;
+    body.first = first;
+    body.begin = cursor - 1;
+    body.segment = new Segment();
+    unit->segments.push_back(body.segment);
+
+    for (depth = 1; depth > 0 && cursor < limit; cursor ++)
+	if ((*buffer)[cursor].kind == '{')
+	    depth ++;
+	else if ((*buffer)[cursor].kind == '}')
+	    depth --;
+
+    body.end = cursor;
+    unit->bodies.push_back(body);
+
+    newSegment();
+    advance();
+}
+
+
+/*
+ * Function:	skipBody
+ *
+ * Description:	Skip the body of a function whose scope is the top-level
+ *		scope, and close that scope.
+ */
+
+static void skipBody()
+{
+    if (lookahead != '{')
+	error();
+
+    closeScope();
+
+    if (!skipBraces()) {
+	lookahead = DONE;
+	error();
+    }
+
+    advance();
+}
+
+
 /*
  * Function:	globalDeclarator
  *
@@ -935,11 +1331,13 @@ static void remainingDeclarators(int typespec)
 
 static void globalOrFunction()
 {
+    unsigned indirection, first = cursor - 1;
+    Parameters params;
     int typespec;
-    unsigned indirection;
     string name;
 
 
+    checkLimit();
     typespec = specifier();
     indirection = pointers();
     name = identifier();
@@ -959,14 +1357,18 @@ static void globalOrFunction()
 	    remainingDeclarators(typespec);
 
 	} else {
+	    function = name;
 	    openScope();
-	    defineFunction(name, Type(typespec, indirection, parameters()));
+	    params = parameters();
+	    defineFunction(name, Type(typespec, indirection, &params));
 	    match(')');
-	    match('{');
-	    declarations();
-	    statements(Type(typespec, indirection));
-	    closeScope();
-	    match('}');
+
+	    if (splitting)
+		deferBody(Type(typespec, indirection), first);
+	    else if (skimming)
+		skipBody();
+	    else
+		functionBody(Type(typespec, indirection));
 	}
 
     } else {
@@ -977,20 +1379,301 @@ static void globalOrFunction()
 
 
 /*
- * Function:	main
+ * Function:	settleBody
+ *
+ * Description:	Mark a body of the given split unit as checked, and move
+ *		the first unchecked body past any checked ones, counting
+ *		their diagnostics.
+ */
+
+void settleBody(Split &split, Body &body)
+{
+    lock_guard<mutex> guard(split.settling);
+
+    body.checked = true;
+
+    while (split.frontier < split.bodies.size() &&
+	    split.bodies[split.frontier].checked)
+	split.settled += split.bodies[split.frontier ++].segment->diagnostics.size();
+}
+
+
+/*
+ * Function:	checkBodies
  *
- * Description:	Analyze the standard input stream.
+ * Description:	Check the deferred function bodies of the given split
+ *		unit, starting at the one indexed by NEXT, until there are
+ *		none left.  Each thread running this function takes the
+ *		next unchecked body, and finds the globals in the history
+ *		of the unit.  If RECORDING, the globals each body names are
+ *		kept with it.  The output and diagnostics of the thread go
+ *		back where they were once we're done.
  */
 
-int main()
+void checkBodies(Split *split, const Buffer *tokens, atomic<unsigned> *next,
+	bool recording)
 {
-    openScope();
-    lookahead = yylex();
-    lexbuf = yytext;
+    Diagnostics *log = diagnostics;
+    ostream *out = output;
+    unsigned i;
+
+
+    preserveScopes(&split->history);
+    unit = split;
+    buffer = tokens;
+    location = &line;
+
+    while ((i = (*next) ++) < split->bodies.size()) {
+	Body &body = split->bodies[i];
+
+	if (body.replayed)
+	    continue;
+
+	output = &body.segment->output;
+	diagnostics = &body.segment->diagnostics;
+	function = body.function;
+	current = &body;
+	resumeScope(body.scope, body.snapshot);
+	cursor = body.begin;
+	limit = body.end;
+
+	if (recording)
+	    recordUses(&body.uses);
+
+	try {
+	    checkLimit();
+	    advance();
+	    functionBody(body.returnType);
+	} catch (SyntaxError &) {
+	    body.segment->failed = true;
+	}
+
+	recordUses(nullptr);
+	settleBody(*split, body);
+    }
+
+    current = nullptr;
+    unit = nullptr;
+    output = out;
+    diagnostics = log;
+}
+
+
+/*
+ * Function:	splitUnit
+ *
+ * Description:	Make the first pass over a translation unit in the given
+ *		buffer, declaring its globals and deferring its function
+ *		bodies, with everything reported going into new segments
+ *		of the given split.  The bodies are left for the caller to
+ *		check.  The calling thread preserves the outermost scope in
+ *		the history of the split until the unit is released, but
+ *		its output and diagnostics go back where they were, since
+ *		the segments go with the unit.
+ */
+
+void splitUnit(Split &split, const Buffer &tokens)
+{
+    Diagnostics *log = diagnostics;
+    ostream *out = output;
+
+
+    preserveScopes(&split.history);
+    seed();
+
+    unit = &split;
+    splitting = true;
+    buffer = &tokens;
+    location = &line;
+    cursor = 0;
+    limit = tokens.size();
+    newSegment();
+
+    try {
+	advance();
+
+	while (lookahead != DONE)
+	    globalOrFunction();
+
+    } catch (SyntaxError &) {
+	split.segments.back()->failed = true;
+    }
+
+    closeScope();
+    splitting = false;
+    unit = nullptr;
+    output = out;
+    diagnostics = log;
+}
+
+
+/*
+ * Function:	checkBody
+ *
+ * Description:	Check a deferred function body of the given split unit
+ *		again, from the tokens of the given buffer between BEGIN
+ *		and END, replacing whatever its segment held.  The body is
+ *		checked in a copy of its scope, so this may be done any
+ *		number of times, but only by the thread that split it.  As
+ *		with splitting, the output and diagnostics of the thread go
+ *		back where they were.
+ */
+
+void checkBody(Split &split, Body &body, const Buffer &tokens, unsigned begin,
+	unsigned end)
+{
+    Segment *segment = body.segment;
+    Diagnostics *log = diagnostics;
+    ostream *out = output;
+
+
+    segment->output.str("");
+    segment->diagnostics = Diagnostics();
+    segment->failed = false;
+
+    output = &segment->output;
+    diagnostics = &segment->diagnostics;
+    function = body.function;
+    current = &body;
+    reopenScope(body.scope, body.snapshot);
+
+    unit = &split;
+    buffer = &tokens;
+    location = &line;
+    cursor = begin;
+    limit = end;
+
+    try {
+	advance();
+	functionBody(body.returnType);
+    } catch (SyntaxError &) {
+	segment->failed = true;
+    }
+
+    current = nullptr;
+    unit = nullptr;
+    output = out;
+    diagnostics = log;
+}
+
+
+/*
+ * Function:	releaseUnit
+ *
+ * Description:	Release the segments, bodies, and scopes of a translation
+ *		unit that was split by the calling thread, so that another
+ *		can be split with the same split.
+ */
+
+void releaseUnit(Split &split)
+{
+    for (auto segment : split.segments)
+	delete segment;
+
+    split.segments.clear();
+    split.bodies.clear();
+    split.passed = split.frontier = split.settled = 0;
+    buffer = nullptr;
+    releaseScopes();
+    preserveScopes(nullptr);
+}
+
+
+/*
+ * Function:	checkPrelude
+ *
+ * Description:	Read the prelude, if one was given, into an outermost scope
+ *		that is then released, so that one that can't be read is
+ *		reported before anything else is done.
+ */
+
+void checkPrelude()
+{
+    if (options->prelude != nullptr) {
+	seed();
+	releaseScopes();
+    }
+}
+
+
+/*
+ * Function:	checkUnit
+ *
+ * Description:	Check all of a translation unit from the given buffer on
+ *		the calling thread, starting from the given prelude and
+ *		writing slots and constants if asked, and return whether it
+ *		was checked
+ *		to the end instead of stopping at a syntax error or the
+ *		limit on errors.  The output and diagnostics go wherever
+ *		those of the thread go.  Nothing here ever exits, so a
+ *		prelude that can't be read is thrown to the caller once
+ *		everything is released.
+ */
+
+bool checkUnit(const Buffer &tokens, const char *prelude, bool dumping,
+	bool folding)
+{
+    const Options *previous = options;
+    const int *position = location;
+    Options chosen = {dumping, prelude, folding};
+    bool checked = true, seeded = true;
+
+
+    options = &chosen;
+    buffer = &tokens;
+    location = &line;
+    cursor = 0;
+    limit = tokens.size();
+
+    try {
+	seed();
+	advance();
+
+	while (lookahead != DONE)
+	    globalOrFunction();
+
+	closeScope();
+
+    } catch (SyntaxError &) {
+	checked = false;
+    } catch (PreludeError &) {
+	seeded = false;
+    }
+
+    releaseScopes();
+    options = previous;
+    buffer = nullptr;
+    location = position;
+
+    if (!seeded)
+	throw PreludeError();
+
+    return checked;
+}
+
+
+/*
+ * Function:	checkInput
+ *
+ * Description:	Check all of the standard input stream on the calling
+ *		thread, and return its outermost scope, which is closed but
+ *		not released.  When skimming, the function bodies are
+ *		skipped by the lexer instead.  A syntax error exits.
+ */
+
+Scope *checkInput(bool skim)
+{
+    Scope *globals;
+
+
+    skimming = skim;
+    globals = seed();
+    advance();
 
     while (lookahead != DONE)
 	globalOrFunction();
 
     closeScope();
-    exit(EXIT_SUCCESS);
+    skimming = false;
+    return globals;
 }
@@ -0,0 +1,86 @@
+/*
+ * File:	parser.h
+ *
+ * Description:	This file contains the public function declarations for the
+ *		recursive-descent parser for Simple C.
+ *
+ *		A translation unit can also be split, as when checking in
+ *		parallel.  A first pass declares the globals and defers the
+ *		function bodies, which are then checked later, each against
+ *		a snapshot of the outermost scope as it was at its
+ *		definition.  The output and diagnostics go into segments,
+ *		one for each body and one for each stretch of globals
+ *		between them, in source order, so that whatever is driving
+ *		the parser can check the bodies as it likes and write the
+ *		segments once they are done.  Everything about a unit that
+ *		was split is kept in a split belonging to the caller, which
+ *		is handed to each thread checking its bodies, so any other
+ *		thread is free to check units of its own.
+ *
+ *		The options the standard input is checked with, and the
+ *		diagnostics reported when it isn't split, are left for the
+ *		driver to set and write.
+ */
+
+# ifndef PARSER_H
+# define PARSER_H
+# include <atomic>
+# include <mutex>
+# include <sstream>
+# include <string>
+# include <vector>
+# include "Buffer.h"
+# include "checker.h"
+
+class PreludeError {};
+
+struct Options {
+    bool dumping;
+    const char *prelude;
+    bool folding;
+};
+
+struct Segment {
+    std::ostringstream output;
+    Diagnostics diagnostics;
+    bool failed = false;
+};
+
+struct Body {
+    Scope *scope;
+    Type returnType;
+    unsigned snapshot;
+    unsigned first, begin, end;
+    unsigned before;
+    bool checked, replayed;
+    Segment *segment;
+    std::string function;
+    Uses uses;
+};
+
+struct Split {
+    std::vector<Segment *> segments;
+    std::vector<Body> bodies;
+    unsigned passed = 0, frontier = 0;
+    std::atomic<unsigned> settled{0};
+    std::mutex settling;
+    History history;
+};
+
+extern Options defaults;
+extern Diagnostics standard;
+
+int finish(int status);
+Scope *checkInput(bool skim);
+bool checkUnit(const Buffer &tokens, const char *prelude, bool dumping,
+	bool folding);
+void splitUnit(Split &split, const Buffer &tokens);
+void checkBody(Split &split, Body &body, const Buffer &tokens,
+	unsigned begin, unsigned end);
+void checkBodies(Split *split, const Buffer *tokens,
+	std::atomic<unsigned> *next, bool recording);
+void settleBody(Split &split, Body &body);
+void releaseUnit(Split &split);
+void checkPrelude();
+
+# endif /* PARSER_H */
@@ -0,0 +1,311 @@
+/*
+ * File:	prelude.cpp
+ *
+ * Description:	This file contains the function definitions for writing
+ *		and reading preludes in Simple C.
+ *
+ *		A prelude is a single binary image that is mapped into
+ *		memory rather than read.  It holds no pointers, only
+ *		indices and offsets, so it can be mapped at any address.
+ *		After the header come four tables, one after the other:
+ *
+ *		types		each distinct type used, with its kind,
+ *				specifier, indirection, and array length,
+ *				or the first and number of its parameters
+ *		parameters	the types of the parameters of every
+ *				function type, as indices into the types
+ *		symbols		each symbol in the order it was declared,
+ *				with its name as an offset into the strings
+ *				and its type as an index into the types
+ *		strings		the characters of the names
+ *
+ *		A parameter type always comes before the function type
+ *		that uses it, so reading the types in order lets us intern
+ *		each one with the types it refers to already interned.
+ *		Handles are only good for a single run, so they are never
+ *		written.  Specifiers are written as tokens, so the version
+ *		must be changed whenever the tokens do.
+ */
+
+# include <cstdint>
+# include <cstring>
+# include <fstream>
+# include <unordered_map>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# include "checker.h"
+# include "prelude.h"
+# include "tokens.h"
+
+using namespace std;
+
+static const char magic[4] = {'S', 'C', 'C', 'P'};
+static const uint32_t version = 1;
+
+enum { K_ERROR, K_SCALAR, K_ARRAY, K_FUNCTION, K_PROTOTYPE };
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t types, parameters, symbols, strings;
+};
+
+struct Record {
+    uint32_t kind;
+    int32_t specifier;
+    uint32_t indirection;
+    uint32_t count;
+    uint64_t length;
+};
+
+struct Entry {
+    uint32_t name;
+    uint32_t size;
+    uint32_t type;
+};
+
+namespace {
+    struct Image {
+	vector<Record> types;
+	vector<uint32_t> parameters;
+	vector<Entry> symbols;
+	string strings;
+	unordered_map<unsigned, uint32_t> indices;
+    };
+}
+
+
+/*
+ * Function:	add
+ *
+ * Description:	Add a type to the image if it isn't there already, and
+ *		return its index.  For a function type, we have to add its
+ *		parameters first, which may add more types, so we can't
+ *		hang on to a reference to its record until they're done.
+ */
+
+static uint32_t add(Image &image, const Type &type)
+{
+    Record record = {K_ERROR, 0, 0, 0, 0};
+    vector<uint32_t> parameters;
+
+
+    auto it = image.indices.find(type.handle());
+
+    if (it != image.indices.end())
+	return it->second;
+
+    if (!type.isError()) {
+	record.specifier = type.specifier();
+	record.indirection = type.indirection();
+
+	if (type.isArray()) {
+	    record.kind = K_ARRAY;
+	    record.length = type.length();
+
+	} else if (!type.isFunction())
+	    record.kind = K_SCALAR;
+
+	else if (type.parameters() == nullptr)
+	    record.kind = K_FUNCTION;
+
+	else {
+	    record.kind = K_PROTOTYPE;
+
+	    for (auto &parameter : *type.parameters())
+		parameters.push_back(add(image, parameter));
+
+	    record.count = parameters.size();
+	    record.length = image.parameters.size();
+	    image.parameters.insert(image.parameters.end(),
+		    parameters.begin(), parameters.end());
+	}
+    }
+
+    image.types.push_back(record);
+    return image.indices[type.handle()] = image.types.size() - 1;
+}
+
+
+/*
+ * Function:	writePrelude
+ *
+ * Description:	Write the symbols in the given scope to a prelude at the
+ *		given path, and return whether we succeeded.
+ */
+
+bool writePrelude(const string &path, const Scope *scope)
+{
+    Image image;
+    Header header;
+    ofstream file(path, ios::binary);
+
+
+    for (auto symbol : scope->symbols()) {
+	Entry entry;
+
+	entry.name = image.strings.size();
+	entry.size = symbol->name().size();
+	entry.type = add(image, symbol->type());
+	image.symbols.push_back(entry);
+	image.strings += symbol->name();
+    }
+
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.types = image.types.size();
+    header.parameters = image.parameters.size();
+    header.symbols = image.symbols.size();
+    header.strings = image.strings.size();
+
+    file.write((const char *) &header, sizeof(header));
+    file.write((const char *) image.types.data(), image.types.size() * sizeof(Record));
+    file.write((const char *) image.parameters.data(), image.parameters.size() * sizeof(uint32_t));
+    file.write((const char *) image.symbols.data(), image.symbols.size() * sizeof(Entry));
+    file.write(image.strings.data(), image.strings.size());
+    return file.good();
+}
+
+
+/*
+ * Function:	load
+ *
+ * Description:	Intern the types and declare the symbols of a prelude
+ *		mapped at the given address with the given size, and
+ *		return whether it was valid.  Each record is checked
+ *		before it is used, so a damaged prelude is rejected rather
+ *		than read past its end or made into types that can't exist.
+ */
+
+static bool load(const char *base, size_t size, Scope *scope)
+{
+    const Header *header;
+    const Record *records;
+    const uint32_t *parameters;
+    const Entry *entries;
+    const char *strings;
+    vector<Type> types;
+    Parameters list;
+
+
+    header = (const Header *) base;
+
+    if (size < sizeof(Header) || memcmp(header->magic, magic, sizeof(magic)) != 0)
+	return false;
+
+    if (header->version != version)
+	return false;
+
+    if (size != sizeof(Header) + header->types * sizeof(Record) +
+	    header->parameters * sizeof(uint32_t) +
+	    header->symbols * sizeof(Entry) + header->strings)
+	return false;
+
+    records = (const Record *) (header + 1);
+    parameters = (const uint32_t *) (records + header->types);
+    entries = (const Entry *) (parameters + header->parameters);
+    strings = (const char *) (entries + header->symbols);
+    types.reserve(header->types);
+
+    for (unsigned i = 0; i < header->types; i ++) {
+	const Record &record = records[i];
+
+	if (record.kind != K_ERROR &&
+		!Type::valid(record.specifier, record.indirection))
+	    return false;
+
+	switch (record.kind) {
+	case K_ERROR:
+	    types.push_back(Type());
+	    break;
+
+	case K_SCALAR:
+	    types.push_back(Type(record.specifier, record.indirection));
+	    break;
+
+	case K_ARRAY:
+	    types.push_back(Type(record.specifier, record.indirection, record.length));
+	    break;
+
+	case K_FUNCTION:
+	    types.push_back(Type(record.specifier, record.indirection, nullptr));
+	    break;
+
+	case K_PROTOTYPE:
+	    if (record.length + record.count > header->parameters)
+		return false;
+
+	    list.clear();
+
+	    for (unsigned j = 0; j < record.count; j ++)
+		if (parameters[record.length + j] < i)
+		    list.push_back(types[parameters[record.length + j]]);
+
+	    if (list.size() != record.count)
+		return false;
+
+	    types.push_back(Type(record.specifier, record.indirection, &list));
+	    break;
+
+	default:
+	    return false;
+	}
+    }
+
+    for (unsigned i = 0; i < header->symbols; i ++) {
+	const Entry &entry = entries[i];
+
+	if (entry.type >= types.size() || entry.name > header->strings ||
+		entry.size > header->strings - entry.name)
+	    return false;
+    }
+
+    scope->reserve(scope->symbols().size() + header->symbols);
+
+    for (unsigned i = 0; i < header->symbols; i ++) {
+	const Entry &entry = entries[i];
+	importSymbol(string(strings + entry.name, entry.size), types[entry.type]);
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	readPrelude
+ *
+ * Description:	Map the prelude at the given path into memory and declare
+ *		its symbols in the given scope, which must be the outermost
+ *		scope.
+ *		Return whether we succeeded.  The names are copied into the
+ *		symbols, so the prelude is unmapped once we're done.
+ */
+
+bool readPrelude(const string &path, Scope *scope)
+{
+    struct stat status;
+    void *base;
+    bool valid;
+    int fd;
+
+
+    if ((fd = open(path.c_str(), O_RDONLY)) < 0)
+	return false;
+
+    if (fstat(fd, &status) < 0 || status.st_size == 0) {
+	close(fd);
+	return false;
+    }
+
+    base = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+	return false;
+
+    valid = load((const char *) base, status.st_size, scope);
+    munmap(base, status.st_size);
+    return valid;
+}
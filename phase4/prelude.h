@@ -0,0 +1,20 @@
+/*
+ * File:	prelude.h
+ *
+ * Description:	This file contains the function declarations for preludes
+ *		in Simple C.  A prelude is the checked outermost scope of
+ *		a file of common declarations, such as the prototypes of
+ *		the C library, saved so that it can be loaded into the
+ *		outermost scope of another file without parsing or checking
+ *		those declarations again.
+ */
+
+# ifndef PRELUDE_H
+# define PRELUDE_H
+# include <string>
+# include "Scope.h"
+
+bool writePrelude(const std::string &path, const Scope *scope);
+bool readPrelude(const std::string &path, Scope *scope);
+
+# endif /* PRELUDE_H */
@@ -0,0 +1,271 @@
+/*
+ * File:	server.cpp
+ *
+ * Description:	This file contains the function definitions for serving
+ *		requests from clients over a Unix domain socket in Simple C.
+ *
+ *		A request is the length of its data as four bytes, sent
+ *		along with the standard input, output, and error of the
+ *		client as three descriptors, and then the data itself: the
+ *		working directory of the client and its arguments, each
+ *		ending with a null character.  The reply is the exit status
+ *		as four bytes.
+ *
+ *		The server never checks anything itself.  For each request,
+ *		it forks a worker that takes on the descriptors, directory,
+ *		and arguments of the client, and runs just as if the client
+ *		had been the compiler.  All the output goes straight to the
+ *		client, and every way out of the compiler is simply an exit,
+ *		so the worker sends back its status as it exits, once its
+ *		output is flushed.  A worker that is killed sends nothing,
+ *		and the client sees the connection close instead.
+ *
+ *		The worker starts with whatever the server warmed up before
+ *		serving, such as the interned types, and pays nothing for
+ *		loading or starting the program.  Since each request has
+ *		its own worker, requests don't wait for each other.
+ */
+
+# include <cerrno>
+# include <csignal>
+# include <cstdint>
+# include <cstdlib>
+# include <cstring>
+# include <iostream>
+# include <vector>
+# include <sys/socket.h>
+# include <sys/stat.h>
+# include <sys/un.h>
+# include <unistd.h>
+# include "server.h"
+
+using namespace std;
+
+static const uint32_t largest = 1 << 20;
+
+
+/*
+ * Function:	readAll
+ *
+ * Description:	Read exactly SIZE bytes from a descriptor, and return
+ *		whether we could.
+ */
+
+static bool readAll(int fd, char *data, size_t size)
+{
+    ssize_t n;
+
+
+    while (size > 0) {
+	if ((n = read(fd, data, size)) <= 0) {
+	    if (n < 0 && errno == EINTR)
+		continue;
+
+	    return false;
+	}
+
+	data += n;
+	size -= n;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	receive
+ *
+ * Description:	Receive a request on a connection, filling in its data
+ *		and the three descriptors of the client, and return whether
+ *		it was well formed.
+ */
+
+static bool receive(int connection, string &data, int fds[3])
+{
+    char control[CMSG_SPACE(3 * sizeof(int))];
+    struct msghdr message;
+    struct cmsghdr *header;
+    struct iovec part;
+    uint32_t length;
+
+
+    memset(&message, 0, sizeof(message));
+    part.iov_base = &length;
+    part.iov_len = sizeof(length);
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    if (recvmsg(connection, &message, 0) != sizeof(length))
+	return false;
+
+    header = CMSG_FIRSTHDR(&message);
+
+    if (header == nullptr || header->cmsg_level != SOL_SOCKET ||
+	    header->cmsg_type != SCM_RIGHTS ||
+	    header->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+	return false;
+
+    memcpy(fds, CMSG_DATA(header), 3 * sizeof(int));
+
+    if (length > largest)
+	return false;
+
+    data.resize(length);
+    return readAll(connection, &data[0], length);
+}
+
+
+/*
+ * Function:	reply
+ *
+ * Description:	Send the exit status of the worker back over the
+ *		connection, which is given as the argument.  This is called
+ *		as the worker exits, after the functions registered by the
+ *		compiler itself, so we flush the output first to make sure
+ *		the client has all of it before it exits too.
+ */
+
+static void reply(int status, void *argument)
+{
+    int connection = (int) (intptr_t) argument;
+    int32_t result = status;
+
+
+    cout << flush;
+    cerr << flush;
+    fflush(nullptr);
+
+    if (write(connection, &result, sizeof(result)) != sizeof(result))
+	return;
+}
+
+
+/*
+ * Function:	perform
+ *
+ * Description:	Perform a request on a connection in the worker by taking
+ *		on the descriptors, directory, and arguments of the client,
+ *		and running the compiler.  This never returns.
+ */
+
+static void perform(int connection, int (*run)(int, char *[]))
+{
+    vector<char *> args;
+    string data, directory;
+    size_t start, end;
+    int fds[3];
+
+
+    signal(SIGCHLD, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+
+    if (!receive(connection, data, fds))
+	_exit(EXIT_FAILURE);
+
+    for (start = 0; start < data.size(); start = end + 1) {
+	end = data.find('\0', start);
+
+	if (end == string::npos)
+	    break;
+
+	if (directory.empty())
+	    directory = data.substr(start, end - start);
+	else
+	    args.push_back(&data[start]);
+    }
+
+    for (int i = 0; i < 3; i ++) {
+	dup2(fds[i], i);
+
+	if (fds[i] > 2)
+	    close(fds[i]);
+    }
+
+    on_exit(reply, (void *) (intptr_t) connection);
+
+    if (directory.empty() || chdir(directory.c_str()) < 0) {
+	cerr << "scc: cannot change to " << directory << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    args.insert(args.begin(), (char *) "scc");
+    args.push_back(nullptr);
+    exit(run(args.size() - 1, args.data()));
+}
+
+
+/*
+ * Function:	serve
+ *
+ * Description:	Listen on a Unix domain socket at the given PATH, replacing
+ *		any socket left there, and serve requests with the given
+ *		function for running the compiler until we are killed.
+ *		Return the exit status if we can't listen.  Anything at the
+ *		path other than a socket is left alone, since the path may
+ *		just be mistyped.  Workers write files as we would, so the
+ *		socket is made so that only we may connect to it.
+ */
+
+int serve(const string &path, int (*run)(int argc, char *argv[]))
+{
+    struct sockaddr_un address;
+    int listener, connection;
+    struct stat st;
+    mode_t mask;
+
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path)) {
+	cerr << "scc: socket path too long: " << path << endl;
+	return EXIT_FAILURE;
+    }
+
+    strcpy(address.sun_path, path.c_str());
+
+    if (lstat(path.c_str(), &st) == 0) {
+	if (!S_ISSOCK(st.st_mode)) {
+	    cerr << "scc: not a socket: " << path << endl;
+	    return EXIT_FAILURE;
+	}
+
+	unlink(path.c_str());
+    }
+
+    mask = umask(077);
+
+    if ((listener = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+	    bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 ||
+	    listen(listener, SOMAXCONN) < 0) {
+	umask(mask);
+	cerr << "scc: cannot listen on " << path << endl;
+	return EXIT_FAILURE;
+    }
+
+    umask(mask);
+
+    cout << flush;
+    cerr << flush;
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+
+    while (true) {
+	if ((connection = accept(listener, nullptr, nullptr)) < 0) {
+	    if (errno == EINTR || errno == ECONNABORTED)
+		continue;
+
+	    cerr << "scc: cannot accept on " << path << endl;
+	    return EXIT_FAILURE;
+	}
+
+	if (fork() == 0) {
+	    close(listener);
+	    perform(connection, run);
+	}
+
+	close(connection);
+    }
+}
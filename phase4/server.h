@@ -0,0 +1,16 @@
+/*
+ * File:	server.h
+ *
+ * Description:	This file contains the function declarations for serving
+ *		requests from clients over a Unix domain socket in Simple C,
+ *		so that each request is checked by an already warm process
+ *		instead of a new one.
+ */
+
+# ifndef SERVER_H
+# define SERVER_H
+# include <string>
+
+int serve(const std::string &path, int (*run)(int argc, char *argv[]));
+
+# endif /* SERVER_H */
@@ -0,0 +1,298 @@
+/*
+ * File:	sidecar.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		sidecars of results in Simple C.
+ *
+ *		A sidecar starts with a header giving its magic number,
+ *		version, and the number of entries.  Each entry is its key,
+ *		whether checking failed, the output, the notes, each note
+ *		being its line, the number of its message, and the spelling
+ *		of its argument, and the uses, each being a name and a type.
+ *		Strings are written as their length followed by their
+ *		characters.  The sidecar ends with a checksum of everything
+ *		before it, made as a key for the cache is, so it also fails
+ *		to match if the compiler has changed.  A sidecar whose
+ *		checksum doesn't match, or that names a message that isn't
+ *		known, is treated as empty, which only means checking
+ *		everything.
+ *
+ *		A sidecar is written to a temporary file first and then
+ *		renamed, so that a run that is interrupted, or another run
+ *		reading it at the same time, sees either all of it or the
+ *		one before.
+ */
+
+# include <cstdint>
+# include <cstdio>
+# include <cstring>
+# include <fstream>
+# include <sstream>
+# include <unistd.h>
+# include "Diagnostics.h"
+# include "cache.h"
+# include "sidecar.h"
+
+using namespace std;
+
+static const char magic[4] = {'S', 'C', 'C', 'I'};
+static const uint32_t version = 2;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t entries;
+};
+
+
+/*
+ * Function:	take
+ *
+ * Description:	Take the given number of bytes from the data at the given
+ *		position, moving past them, and return whether there were
+ *		that many.
+ */
+
+static bool take(const string &data, size_t &at, void *bytes, size_t n)
+{
+    if (data.size() - at < n)
+	return false;
+
+    memcpy(bytes, data.data() + at, n);
+    at += n;
+    return true;
+}
+
+
+/*
+ * Function:	take
+ *
+ * Description:	Take a string from the data at the given position, moving
+ *		past it, and return whether there was one.
+ */
+
+static bool take(const string &data, size_t &at, string &s)
+{
+    uint32_t length;
+
+
+    if (!take(data, at, &length, sizeof(length)) || data.size() - at < length)
+	return false;
+
+    s.assign(data, at, length);
+    at += length;
+    return true;
+}
+
+
+/*
+ * Function:	put
+ *
+ * Description:	Write a string to the given stream with its length.
+ */
+
+static void put(ostream &ostr, const string &s)
+{
+    uint32_t length = s.size();
+
+
+    ostr.write((const char *) &length, sizeof(length));
+    ostr.write(s.data(), s.size());
+}
+
+
+/*
+ * Function:	Sidecar::Sidecar (constructor)
+ *
+ * Description:	Initialize this sidecar to use the given file, reading the
+ *		entries already in it, if any.
+ */
+
+Sidecar::Sidecar(const string &path)
+    : _path(path), _stored(false)
+{
+    if (!load())
+	_found.clear();
+}
+
+
+/*
+ * Function:	Sidecar::load
+ *
+ * Description:	Read the entries of the file of this sidecar, and return
+ *		whether it was whole and undamaged.
+ */
+
+bool Sidecar::load()
+{
+    ifstream file(_path, ios::binary);
+    ostringstream contents;
+    uint32_t count, message;
+    uint8_t failed;
+    Header header;
+    string data, key, name, type, checksum;
+    size_t at = 0, end;
+    Entry entry;
+    Note note;
+
+
+    if (!file)
+	return false;
+
+    contents << file.rdbuf();
+    data = contents.str();
+
+    if (!take(data, at, &header, sizeof(header)) ||
+	    memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+	    header.version != version)
+	return false;
+
+    for (uint64_t i = 0; i < header.entries; i ++) {
+	if (!take(data, at, key) || !take(data, at, &failed, sizeof(failed)) ||
+		!take(data, at, entry.output) || !take(data, at, &count, sizeof(count)))
+	    return false;
+
+	entry.failed = failed != 0;
+	entry.notes.clear();
+
+	for (uint32_t j = 0; j < count; j ++) {
+	    int32_t line;
+
+	    if (!take(data, at, &line, sizeof(line)) ||
+		    !take(data, at, &message, sizeof(message)) ||
+		    Diagnostics::known(message) == nullptr ||
+		    !take(data, at, note.argument))
+		return false;
+
+	    note.line = line;
+	    note.message = message;
+	    entry.notes.push_back(note);
+	}
+
+	if (!take(data, at, &count, sizeof(count)))
+	    return false;
+
+	entry.uses.clear();
+
+	for (uint32_t j = 0; j < count; j ++) {
+	    if (!take(data, at, name) || !take(data, at, type))
+		return false;
+
+	    entry.uses.push_back(make_pair(name, type));
+	}
+
+	_found[key] = entry;
+    }
+
+    end = at;
+
+    if (!take(data, at, checksum) || at != data.size())
+	return false;
+
+    return checksum == Cache::key(data.substr(0, end), "");
+}
+
+
+/*
+ * Function:	Sidecar::find
+ *
+ * Description:	Find the entry with the given key, filling it in and
+ *		keeping it to be written back, and return whether it was
+ *		found.
+ */
+
+bool Sidecar::find(const string &key, Entry &entry)
+{
+    auto it = _found.find(key);
+
+
+    if (it == _found.end())
+	return false;
+
+    entry = it->second;
+    _kept[key] = it->second;
+    return true;
+}
+
+
+/*
+ * Function:	Sidecar::store
+ *
+ * Description:	Store an entry with the given key, to be written back.
+ */
+
+void Sidecar::store(const string &key, const Entry &entry)
+{
+    _kept[key] = entry;
+    _stored = true;
+}
+
+
+/*
+ * Function:	Sidecar::write
+ *
+ * Description:	Write the entries found or stored back to the file of this
+ *		sidecar, replacing what was there, and return whether we
+ *		could.  If nothing was stored and every entry was found
+ *		again, the file already holds just what we would write.
+ */
+
+bool Sidecar::write() const
+{
+    string temporary = _path + ".tmp." + to_string(getpid());
+    ostringstream contents;
+    Header header;
+
+
+    if (!_stored && _kept.size() == _found.size())
+	return true;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.entries = _kept.size();
+
+    contents.write((const char *) &header, sizeof(header));
+
+    for (auto &kept : _kept) {
+	const Entry &entry = kept.second;
+	uint8_t failed = entry.failed;
+	uint32_t count = entry.notes.size();
+
+	put(contents, kept.first);
+	contents.write((const char *) &failed, sizeof(failed));
+	put(contents, entry.output);
+	contents.write((const char *) &count, sizeof(count));
+
+	for (auto &note : entry.notes) {
+	    int32_t line = note.line;
+	    uint32_t message = note.message;
+
+	    contents.write((const char *) &line, sizeof(line));
+	    contents.write((const char *) &message, sizeof(message));
+	    put(contents, note.argument);
+	}
+
+	count = entry.uses.size();
+	contents.write((const char *) &count, sizeof(count));
+
+	for (auto &use : entry.uses) {
+	    put(contents, use.first);
+	    put(contents, use.second);
+	}
+    }
+
+    put(contents, Cache::key(contents.str(), ""));
+
+    ofstream file(temporary, ios::binary);
+
+    file << contents.str();
+    file.close();
+
+    if (!file || rename(temporary.c_str(), _path.c_str()) != 0) {
+	unlink(temporary.c_str());
+	return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * File:	sidecar.h
+ *
+ * Description:	This file contains the class definition for sidecars of
+ *		results in Simple C.  A sidecar is a single file kept
+ *		alongside a source file, holding the output, diagnostics,
+ *		and whether checking failed, for each function body checked
+ *		the last time, named by a key made from the text of its
+ *		definition.  Each entry also holds the globals the body
+ *		named, with their types, or none if a name wasn't declared,
+ *		since the results only hold while those are unchanged.
+ *
+ *		Each message is kept as its number in the table of known
+ *		messages, and the lines of the diagnostics are kept
+ *		relative to the start of their body, so that a body that
+ *		has only moved can still use them.  Only the bodies found or stored in a run are
+ *		written back, so the sidecar never holds more than the
+ *		bodies of the source as it was last checked.
+ */
+
+# ifndef SIDECAR_H
+# define SIDECAR_H
+# include <string>
+# include <unordered_map>
+# include <vector>
+
+class Sidecar {
+    typedef std::string string;
+
+public:
+    struct Note {
+	int line;
+	unsigned message;
+	string argument;
+    };
+
+    struct Entry {
+	bool failed;
+	string output;
+	std::vector<Note> notes;
+	std::vector<std::pair<string, string>> uses;
+    };
+
+private:
+    string _path;
+    std::unordered_map<string, Entry> _found, _kept;
+    bool _stored;
+
+    bool load();
+
+public:
+    explicit Sidecar(const string &path);
+
+    bool find(const string &key, Entry &entry);
+    void store(const string &key, const Entry &entry);
+    bool write() const;
+};
+
+# endif /* SIDECAR_H */
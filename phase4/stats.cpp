@@ -0,0 +1,398 @@
+/*
+ * File:	stats.cpp
+ *
+ * Description:	This file contains the definitions of the policy for
+ *		statistics in Simple C that actually counts something.
+ *
+ *		The lookup depths are kept one to a bucket up to a limit,
+ *		and the sizes of scopes in buckets of powers of two, so
+ *		that the outermost scope of a large file doesn't need a
+ *		bucket of its own.  Only buckets that were used are written.
+ *
+ *		The header of an allocation is as large as the strictest
+ *		alignment, so that what follows it is aligned as malloc
+ *		would align it.  The global new and delete are replaced
+ *		only when counting, since this file is part of the library
+ *		and a program linking it shouldn't have its allocator
+ *		replaced for nothing.  STATS names a type, which #if can't
+ *		compare, so COUNTING pastes it onto a macro defined only
+ *		for CountStats.
+ */
+
+# include <atomic>
+# include <cstring>
+# include <new>
+# include <string>
+# include <sys/resource.h>
+# include "stats.h"
+
+using namespace std;
+
+# define COUNTING_CountStats 1
+# define COUNTING_(policy) COUNTING_##policy
+# define COUNTING(policy) COUNTING_(policy)
+
+static const unsigned depths = 16, sizes = 33;
+
+static const char *counters[] = {
+    "finds", "probes", "comparisons", "lookups", "undeclared", "equalities",
+    "promotions",
+};
+
+static const char *objects[] = {
+    "symbols", "scopes",
+};
+
+static const char *memories[] = {
+    "other", "lexer", "tokens", "names", "symbols", "scopes", "types",
+    "parameters", "diagnostics",
+};
+
+struct alignas(alignof(max_align_t)) Header {
+    size_t size;
+    Memory memory;
+};
+
+struct Account {
+    atomic<unsigned long> count, bytes;
+    atomic<long> live, peak;
+};
+
+static atomic<unsigned long> counts[(unsigned) Counter::COUNTERS];
+static atomic<unsigned long> buckets[(unsigned) Histogram::HISTOGRAMS][sizes];
+static atomic<long> live[(unsigned) Object::OBJECTS];
+static atomic<long> peak[(unsigned) Object::OBJECTS];
+static Account accounts[(unsigned) Memory::MEMORIES], heap;
+
+thread_local Memory subsystem = Memory::OTHER;
+
+
+/*
+ * Function:	bucket
+ *
+ * Description:	Return the bucket of the given histogram for a value.
+ */
+
+static unsigned bucket(Histogram histogram, unsigned long value)
+{
+    unsigned n;
+
+
+    if (histogram == Histogram::DEPTH)
+	return value < depths ? value : depths;
+
+    for (n = 0; value > 0; n ++)
+	value >>= 1;
+
+    return n;
+}
+
+
+/*
+ * Function:	label
+ *
+ * Description:	Return the label of a bucket of the given histogram, which
+ *		is the range of values it holds.
+ */
+
+static string label(Histogram histogram, unsigned n)
+{
+    unsigned long low, high;
+
+
+    if (histogram == Histogram::DEPTH)
+	return n < depths ? to_string(n) : to_string(n) + "+";
+
+    if (n < 2)
+	return to_string(n);
+
+    low = 1ul << (n - 1);
+    high = (1ul << n) - 1;
+    return to_string(low) + "-" + to_string(high);
+}
+
+
+/*
+ * Function:	raise
+ *
+ * Description:	Raise the peak of a count to N if it is higher.
+ */
+
+static void raise(atomic<long> &peak, long n)
+{
+    long old = peak.load(memory_order_relaxed);
+
+    while (n > old && !peak.compare_exchange_weak(old, n, memory_order_relaxed))
+	continue;
+}
+
+
+/*
+ * Function:	CountStats::count
+ *
+ * Description:	Add N to the given counter.
+ */
+
+void CountStats::count(Counter counter, unsigned long n)
+{
+    counts[(unsigned) counter].fetch_add(n, memory_order_relaxed);
+}
+
+
+/*
+ * Function:	CountStats::record
+ *
+ * Description:	Count a value in the given histogram.
+ */
+
+void CountStats::record(Histogram histogram, unsigned long value)
+{
+    unsigned n = bucket(histogram, value);
+    buckets[(unsigned) histogram][n].fetch_add(1, memory_order_relaxed);
+}
+
+
+/*
+ * Function:	CountStats::create
+ *
+ * Description:	Count an object coming alive, raising the peak if need be.
+ */
+
+void CountStats::create(Object object)
+{
+    long n = live[(unsigned) object].fetch_add(1, memory_order_relaxed) + 1;
+    raise(peak[(unsigned) object], n);
+}
+
+
+/*
+ * Function:	CountStats::destroy
+ *
+ * Description:	Count an object being destroyed.
+ */
+
+void CountStats::destroy(Object object)
+{
+    live[(unsigned) object].fetch_sub(1, memory_order_relaxed);
+}
+
+
+/*
+ * Function:	charge
+ *
+ * Description:	Charge an allocation of SIZE bytes, or a deallocation if it
+ *		is negative, to the given account.
+ */
+
+static void charge(Account &account, long size)
+{
+    if (size > 0) {
+	account.count.fetch_add(1, memory_order_relaxed);
+	account.bytes.fetch_add(size, memory_order_relaxed);
+    }
+
+    raise(account.peak, account.live.fetch_add(size, memory_order_relaxed) + size);
+}
+
+
+/*
+ * Function:	CountStats::allocate
+ *
+ * Description:	Allocate SIZE bytes for the given subsystem, and return
+ *		them, or a null pointer if there is no memory.
+ */
+
+void *CountStats::allocate(size_t size, Memory memory)
+{
+    Header *header = static_cast<Header *>(malloc(sizeof(Header) + size));
+
+
+    if (header == nullptr)
+	return nullptr;
+
+    header->size = size;
+    header->memory = memory;
+    charge(accounts[(unsigned) memory], size);
+    charge(heap, size);
+    return header + 1;
+}
+
+
+/*
+ * Function:	CountStats::deallocate
+ *
+ * Description:	Deallocate memory given by allocate, which may be null.
+ */
+
+void CountStats::deallocate(void *pointer)
+{
+    Header *header = static_cast<Header *>(pointer) - 1;
+
+
+    if (pointer == nullptr)
+	return;
+
+    charge(accounts[(unsigned) header->memory], - (long) header->size);
+    charge(heap, - (long) header->size);
+    free(header);
+}
+
+
+/*
+ * Function:	CountStats::reallocate
+ *
+ * Description:	Change the size of memory given by allocate, which may be
+ *		null, keeping its subsystem, and return it, or a null
+ *		pointer if there is no memory.
+ */
+
+void *CountStats::reallocate(void *pointer, size_t size)
+{
+    Header *header = static_cast<Header *>(pointer) - 1;
+    void *result;
+
+
+    if (pointer == nullptr)
+	return allocate(size, subsystem);
+
+    if ((result = allocate(size, header->memory)) != nullptr) {
+	memcpy(result, pointer, min(size, header->size));
+	deallocate(pointer);
+    }
+
+    return result;
+}
+
+
+/*
+ * Function:	writeHistogram
+ *
+ * Description:	Write a histogram as an object mapping the label of each
+ *		bucket that was used to its count.
+ */
+
+static void writeHistogram(ostream &ostr, Histogram histogram)
+{
+    const char *separator = "";
+    unsigned long n;
+
+
+    ostr << "{";
+
+    for (unsigned i = 0; i < sizes; i ++)
+	if ((n = buckets[(unsigned) histogram][i].load()) > 0) {
+	    ostr << separator << "\"" << label(histogram, i) << "\": " << n;
+	    separator = ", ";
+	}
+
+    ostr << "}";
+}
+
+
+/*
+ * Function:	CountStats::write
+ *
+ * Description:	Write all the counts as a single JSON object.
+ */
+
+void CountStats::write(ostream &ostr)
+{
+    struct rusage usage;
+
+
+    ostr << "{\n";
+
+    for (unsigned i = 0; i < (unsigned) Counter::COUNTERS; i ++)
+	ostr << "  \"" << counters[i] << "\": " << counts[i].load() << ",\n";
+
+    ostr << "  \"depths\": ";
+    writeHistogram(ostr, Histogram::DEPTH);
+    ostr << ",\n  \"sizes\": ";
+    writeHistogram(ostr, Histogram::SYMBOLS);
+    ostr << ",\n  \"peak\": {";
+
+    for (unsigned i = 0; i < (unsigned) Object::OBJECTS; i ++)
+	ostr << (i > 0 ? ", " : "") << "\"" << objects[i] << "\": " << peak[i].load();
+
+    ostr << "},\n  \"memory\": {\n";
+
+    for (unsigned i = 0; i <= (unsigned) Memory::MEMORIES; i ++) {
+	Account &account = i < (unsigned) Memory::MEMORIES ? accounts[i] : heap;
+
+	ostr << "    \"" << (i < (unsigned) Memory::MEMORIES ? memories[i] : "total");
+	ostr << "\": {\"count\": " << account.count.load();
+	ostr << ", \"bytes\": " << account.bytes.load();
+	ostr << ", \"live\": " << account.live.load();
+	ostr << ", \"peak\": " << account.peak.load() << "}";
+	ostr << (i < (unsigned) Memory::MEMORIES ? ",\n" : "\n");
+    }
+
+    getrusage(RUSAGE_SELF, &usage);
+    ostr << "  },\n  \"rss\": " << usage.ru_maxrss * 1024l << "\n}" << endl;
+}
+
+
+# if COUNTING(STATS)
+
+/*
+ * Function:	operator new
+ *
+ * Description:	Allocate SIZE bytes for the subsystem of the calling thread
+ *		and count them.  These replace the global new and delete in
+ *		all their usual forms.
+ */
+
+void *operator new(size_t size)
+{
+    void *pointer = stats::allocate(size > 0 ? size : 1, subsystem);
+
+
+    if (pointer == nullptr)
+	throw bad_alloc();
+
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    return stats::allocate(size > 0 ? size : 1, subsystem);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    return stats::allocate(size > 0 ? size : 1, subsystem);
+}
+
+
+/*
+ * Function:	operator delete
+ *
+ * Description:	Deallocate memory given by the global new.
+ */
+
+void operator delete(void *pointer) noexcept
+{
+    stats::deallocate(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    stats::deallocate(pointer);
+}
+
+void operator delete(void *pointer, const nothrow_t &) noexcept
+{
+    stats::deallocate(pointer);
+}
+
+void operator delete[](void *pointer, const nothrow_t &) noexcept
+{
+    stats::deallocate(pointer);
+}
+
+# endif /* COUNTING(STATS) */
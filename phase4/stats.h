@@ -0,0 +1,123 @@
+/*
+ * File:	stats.h
+ *
+ * Description:	This file contains the definitions for counting what the
+ *		symbol tables and type system of Simple C are asked to do.
+ *		The counts are kept by a policy chosen at compile time by
+ *		defining STATS:
+ *
+ *		NoStats		counts nothing (the default)
+ *		CountStats	counts everything, and writes the counts as
+ *				JSON at exit when asked to with --stats
+ *
+ *		We count the calls to Scope::find and the slots probed and
+ *		names compared to answer them, the calls to lookup by how
+ *		many scopes out from the innermost one the name was found,
+ *		the calls to Type::operator == and Type::promote, the scopes
+ *		by how many symbols they held when closed, and the most
+ *		symbols and scopes alive at once.
+ *
+ *		We also account for every allocation, by the subsystem
+ *		that asked for it: the allocations, the bytes allocated,
+ *		the bytes still live at exit, and the most bytes live at
+ *		once, along with the most bytes live in all and the peak
+ *		resident set size.  The subsystem is the one named by the
+ *		innermost memory tag alive in the thread, and allocations
+ *		made outside any tag belong to "other".  The allocator of
+ *		the lexer goes through the policy to do this, and when
+ *		counting the global new and delete are replaced too.  Each
+ *		allocation then carries a header with its size and
+ *		subsystem.
+ *
+ *		The counts are shared by all threads, so they are atomic.
+ *		With the default policy every count compiles to nothing,
+ *		every allocation goes straight to malloc, and code that
+ *		only computes something to be counted should be guarded by
+ *		stats::enabled so that it does too.  Memory tags are inlined
+ *		even when not optimizing, so that they cost nothing then.
+ */
+
+# ifndef STATS_H
+# define STATS_H
+# include <cstddef>
+# include <cstdlib>
+# include <ostream>
+
+# ifndef STATS
+# define STATS NoStats
+# endif
+
+enum class Counter : unsigned char {
+    FINDS, PROBES, COMPARISONS, LOOKUPS, UNDECLARED, EQUALITIES, PROMOTIONS,
+    COUNTERS
+};
+
+enum class Histogram : unsigned char {
+    DEPTH, SYMBOLS, HISTOGRAMS
+};
+
+enum class Object : unsigned char {
+    SYMBOL, SCOPE, OBJECTS
+};
+
+enum class Memory : unsigned char {
+    OTHER, LEXER, TOKENS, NAMES, SYMBOLS, SCOPES, TYPES, PARAMETERS,
+    DIAGNOSTICS, MEMORIES
+};
+
+extern thread_local Memory subsystem;
+
+struct NoStats {
+    static constexpr bool enabled = false;
+    static void count(Counter, unsigned long = 1) {}
+    static void record(Histogram, unsigned long) {}
+    static void create(Object) {}
+    static void destroy(Object) {}
+    static void write(std::ostream &) {}
+
+    static void *allocate(size_t size, Memory) {
+	return std::malloc(size);
+    }
+
+    static void *reallocate(void *pointer, size_t size) {
+	return std::realloc(pointer, size);
+    }
+
+    static void deallocate(void *pointer) {
+	std::free(pointer);
+    }
+};
+
+struct CountStats {
+    static constexpr bool enabled = true;
+    static void count(Counter counter, unsigned long n = 1);
+    static void record(Histogram histogram, unsigned long value);
+    static void create(Object object);
+    static void destroy(Object object);
+    static void write(std::ostream &ostr);
+
+    static void *allocate(size_t size, Memory memory);
+    static void *reallocate(void *pointer, size_t size);
+    static void deallocate(void *pointer);
+};
+
+typedef STATS stats;
+
+class MemoryTag {
+    Memory _previous;
+
+public:
+    explicit MemoryTag(Memory memory) __attribute__((always_inline)) {
+	if (stats::enabled) {
+	    _previous = subsystem;
+	    subsystem = memory;
+	}
+    }
+
+    ~MemoryTag() __attribute__((always_inline)) {
+	if (stats::enabled)
+	    subsystem = _previous;
+    }
+};
+
+# endif /* STATS_H */
@@ -0,0 +1,159 @@
+/*
+ * File:	compilers.cpp
+ *
+ * Description:	This file contains a check that compilers of the Simple C
+ *		library can be used by several threads at once.  Two
+ *		threads each compile their own program over and over, with
+ *		compilers made with different options, while the main
+ *		thread splits another program and checks its bodies as the
+ *		compiler does in parallel.  Every result must be just what
+ *		compiling the same program alone gave.  The exit status is
+ *		zero only if they all were.
+ */
+
+# include <atomic>
+# include <cstdio>
+# include <cstdlib>
+# include <sstream>
+# include <string>
+# include <thread>
+# include "../Compiler.h"
+# include "../parser.h"
+# include "../trace.h"
+
+using namespace std;
+
+static const unsigned rounds = 200, functions = 50;
+static atomic<unsigned> mismatches(0), running(2);
+
+
+/*
+ * Function:	program
+ *
+ * Description:	Return a program with the given number of functions, each
+ *		using the globals declared before it, some of them wrongly,
+ *		and with constant expressions.
+ */
+
+static string program(unsigned count, const string &prefix)
+{
+    string text = "int printf(), " + prefix + "0;\n";
+
+
+    for (unsigned i = 1; i <= count; i ++) {
+	string name = prefix + to_string(i);
+
+	text += "long " + name + ";\n";
+	text += "int f" + name + "(int x, char *p)\n{\n";
+	text += "    int a[" + to_string(i) + "];\n";
+	text += "    " + name + " = x + sizeof a + " + to_string(i) + " * 3;\n";
+	text += "    p = " + prefix + to_string(i - 1) + ";\n";
+	text += "    return *p + undeclared" + to_string(i % 7) + ";\n}\n";
+    }
+
+    return text;
+}
+
+
+/*
+ * Function:	same
+ *
+ * Description:	Return whether two results are the same.
+ */
+
+static bool same(const Compiler::Result &left, const Compiler::Result &right)
+{
+    return left.status == right.status && left.output == right.output &&
+	left.errors == right.errors && left.truncated == right.truncated &&
+	left.diagnostics.size() == right.diagnostics.size();
+}
+
+
+/*
+ * Function:	compile
+ *
+ * Description:	Compile the given source with the given compiler over and
+ *		over, counting every result that isn't the expected one.
+ */
+
+static void compile(const Compiler *compiler, const string *source,
+	const Compiler::Result *expected)
+{
+    for (unsigned i = 0; i < rounds; i ++)
+	if (!same(compiler->compile(*source), *expected))
+	    mismatches ++;
+
+    running --;
+}
+
+
+/*
+ * Function:	split
+ *
+ * Description:	Split the given source and check its bodies on this thread
+ *		over and over until the compilers are done, as the language
+ *		server does.
+ */
+
+static void split(const string &source)
+{
+    ostringstream written;
+    Diagnostics log;
+    Buffer tokens;
+    Split unit;
+
+
+    output = &written;
+    diagnostics = &log;
+    tokens.scan(source);
+
+    do {
+	atomic<unsigned> next(0);
+
+	splitUnit(unit, tokens);
+	checkBodies(&unit, &tokens, &next, true);
+	releaseUnit(unit);
+    } while (running > 0);
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Compile two programs on two threads while splitting a
+ *		third, and report whether the results were all the same as
+ *		compiling each one alone.
+ */
+
+int main()
+{
+    Compiler::Options options;
+    string first, second, third;
+
+
+    first = program(functions, "g");
+    second = program(functions * 2, "h");
+    third = program(functions, "k");
+
+    options.slots = options.constants = true;
+    options.limit = 20;
+
+    Compiler plain, slotted(options);
+    Compiler::Result one = plain.compile(first);
+    Compiler::Result two = slotted.compile(second);
+
+    if (one.diagnostics.empty() || two.output.empty()) {
+	printf("compilers: expected diagnostics and output\n");
+	return EXIT_FAILURE;
+    }
+
+    thread a(compile, &plain, &first, &one);
+    thread b(compile, &slotted, &second, &two);
+
+    split(third);
+    a.join();
+    b.join();
+
+    printf("compilers: %u rounds each, %u mismatched\n", rounds, (unsigned) mismatches);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,53 @@
+#!/bin/sh
+#
+# File:		frames.sh
+#
+# Description:	Check that the language server refuses a message whose
+#		header it can't use rather than dying on it.  We send
+#		messages with a length that is missing, negative, not a
+#		number, too large to be a length, and larger than the
+#		server will hold, followed by a well formed session, and
+#		check that each bad one is refused with a parse error and
+#		that the session then goes on as usual.
+#
+#		Environment variables:
+#		SCC	compiler to check (../scc)
+#
+
+SCC=${SCC:-../scc}
+WORKDIR=${TMPDIR:-/tmp}/scc-frames.$$
+
+trap 'rm -rf $WORKDIR' 0 2 15
+mkdir -p $WORKDIR || exit 1
+
+
+# write a message with the given body, giving its length unless another
+# header is given
+
+message() {
+    printf 'Content-Length: %s\r\n\r\n%s' "${2:-${#1}}" "$1"
+}
+
+{
+    printf '\r\n'
+    message '' -5
+    message '' abc
+    message '' 99999999999999999999999999
+    message '' 67108865
+    head -c 67108865 /dev/zero
+    message '{"jsonrpc": "2.0", "id": 1, "method": "initialize"}'
+    message '{"jsonrpc": "2.0", "id": 2, "method": "shutdown"}'
+    message '{"jsonrpc": "2.0", "method": "exit"}'
+} > $WORKDIR/input
+
+$SCC --lsp < $WORKDIR/input > $WORKDIR/output
+status=$?
+refused=`grep -o '"code": -32700' $WORKDIR/output | wc -l`
+
+if [ $status -ne 0 ] || [ $refused -ne 5 ] ||
+	! grep -q '"id": 2, "result": null' $WORKDIR/output; then
+    echo "frames: exit status $status, $refused refused"
+    exit 1
+fi
+
+echo "frames: $refused refused"
@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# File:		prelude.sh
+#
+# Description:	Check that the compiler rejects a damaged prelude rather
+#		than crashing on it.  We write a prelude, check that a
+#		program using it compiles, and then damage one field of
+#		one type record at a time and check that the compiler
+#		reports the prelude unreadable and fails, rather than
+#		aborting or loading it.
+#
+#		A record is 24 bytes, after a header of 24 bytes, and holds
+#		the kind, specifier, indirection, and count of a type as
+#		four-byte integers, then its length as an eight-byte one.
+#		The first record is the type of f, a function, and the
+#		second is the type of p, a scalar.
+#
+#		Environment variables:
+#		SCC	compiler to check (../scc)
+#
+
+SCC=${SCC:-../scc}
+WORKDIR=${TMPDIR:-/tmp}/scc-prelude.$$
+FAILED=0
+
+trap 'rm -rf $WORKDIR' 0 2 15
+mkdir -p $WORKDIR || exit 1
+
+cat > $WORKDIR/prelude.c << EOF2
+int f();
+char *p, a[10];
+long g(int x, char *y) { return x; }
+EOF2
+
+echo 'int main(void) { return f() + g(1, p); }' > $WORKDIR/program.c
+$SCC --write-prelude=$WORKDIR/good < $WORKDIR/prelude.c > /dev/null || exit 1
+
+if ! $SCC --prelude=$WORKDIR/good < $WORKDIR/program.c > /dev/null; then
+    echo "good prelude rejected"
+    exit 1
+fi
+
+
+# damage a copy of the prelude by writing the given bytes at the given
+# offset, and check that the compiler rejects it
+
+damage() {
+    cp $WORKDIR/good $WORKDIR/$1
+    printf "$3" | dd of=$WORKDIR/$1 bs=1 seek=$2 conv=notrunc 2> /dev/null
+    $SCC --prelude=$WORKDIR/$1 < $WORKDIR/program.c > /dev/null 2> $WORKDIR/errors
+    status=$?
+
+    if [ $status -ne 1 ] || ! grep -q "cannot read prelude" $WORKDIR/errors; then
+	echo "$1: exit status $status"
+	FAILED=1
+    else
+	echo "$1: rejected"
+    fi
+}
+
+damage zero-specifier 52 '\0\0\0\0'
+damage huge-specifier 52 '\377\377\0\0'
+damage deep-indirection 56 '\0\220\0\0'
+damage function-specifier 28 '\123\0\0\0'
+damage unknown-kind 48 '\011\0\0\0'
+
+exit $FAILED
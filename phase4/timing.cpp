@@ -0,0 +1,487 @@
+/*
+ * File:	timing.cpp
+ *
+ * Description:	This file contains the definitions for timing the phases
+ *		of Simple C.
+ *
+ *		Each thread keeps its own clock, which charges the time
+ *		since the last change of phase to the phase it is leaving.
+ *		A thread adds its times and spans to the totals when it
+ *		finishes, and the main thread does so as the program exits,
+ *		just before the report and the trace are written.  The times
+ *		of all threads are added, so with several threads the total
+ *		is more than the time that passed, which is also given.
+ *		Times are taken from a clock on the wall rather than the
+ *		processor, which is much cheaper to read, so a thread that
+ *		is ready to run but waiting for a processor is still charged
+ *		for its phase.
+ *
+ *		If asked, and if the system lets us, the instructions,
+ *		cycles, cache misses, and branch misses of each phase are
+ *		counted too, using perf_event_open, counting only the work
+ *		of the thread itself outside the kernel.  Reading the
+ *		counters takes a system call at every change of phase,
+ *		which slows everything down, so it is only done if asked.
+ */
+
+# include <algorithm>
+# include <atomic>
+# include <chrono>
+# include <cstdint>
+# include <cstdio>
+# include <cstdlib>
+# include <cstring>
+# include <fstream>
+# include <iostream>
+# include <mutex>
+# include <vector>
+# include <linux/perf_event.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+# include "Diagnostics.h"
+# include "timing.h"
+
+using namespace std;
+using namespace std::chrono;
+
+static const unsigned phases = (unsigned) Phase::PHASES, events = 4;
+
+static const char *names[] = {
+    "lex", "parse", "scope", "check", "output", "wait",
+};
+
+static const struct {
+    uint64_t config;
+    const char *name;
+} counters[events] = {
+    {PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_COUNT_HW_CACHE_MISSES, "cache-misses"},
+    {PERF_COUNT_HW_BRANCH_MISSES, "branch-misses"},
+};
+
+namespace {
+    struct Open {
+	const char *category;
+	string name;
+	uint64_t start;
+	uint64_t spent[phases], counts[events];
+    };
+
+    struct Span {
+	const char *category;
+	string name;
+	unsigned thread;
+	uint64_t start, duration;
+	uint64_t spent[phases], counts[events];
+    };
+
+    struct Clock {
+	Phase phase;
+	unsigned thread;
+	uint64_t last;
+	uint64_t spent[phases], counts[phases][events], values[events];
+	int fds[events];
+	vector<Open> open;
+	vector<Span> spans;
+
+	Clock();
+	~Clock();
+    };
+}
+
+bool timing;
+
+static steady_clock::time_point origin;
+static bool reporting, counting;
+static const char *path;
+
+static mutex merging;
+static atomic<unsigned> threads;
+static atomic<bool> counted(true);
+static uint64_t spent[phases], counts[phases][events];
+static vector<Span> spans;
+
+static thread_local Clock stopwatch;
+
+
+/*
+ * Function:	now
+ *
+ * Description:	Return the nanoseconds since timing started.
+ */
+
+static uint64_t now()
+{
+    return duration_cast<nanoseconds>(steady_clock::now() - origin).count();
+}
+
+
+/*
+ * Function:	sample
+ *
+ * Description:	Read the counters of the calling thread into VALUES, and
+ *		return whether we could.
+ */
+
+static bool sample(const int fds[], uint64_t values[])
+{
+    struct {
+	uint64_t number, values[events];
+    } data;
+
+
+    if (fds[0] < 0 || read(fds[0], &data, sizeof(data)) != sizeof(data))
+	return false;
+
+    memcpy(values, data.values, sizeof(data.values));
+    return true;
+}
+
+
+/*
+ * Function:	charge
+ *
+ * Description:	Charge the time and counts since the last change of phase
+ *		on the given clock to the phase it is in.
+ */
+
+static void charge(Clock &c)
+{
+    unsigned phase = (unsigned) c.phase;
+    uint64_t t = now(), values[events];
+
+
+    c.spent[phase] += t - c.last;
+    c.last = t;
+
+    if (sample(c.fds, values))
+	for (unsigned i = 0; i < events; i ++) {
+	    c.counts[phase][i] += values[i] - c.values[i];
+	    c.values[i] = values[i];
+	}
+}
+
+
+/*
+ * Function:	close
+ *
+ * Description:	End the span begun last on the given clock, keeping the
+ *		time and counts of each phase during it.
+ */
+
+static void close(Clock &c)
+{
+    Open &open = c.open.back();
+    Span span;
+
+
+    charge(c);
+    span.category = open.category;
+    span.name = move(open.name);
+    span.thread = c.thread;
+    span.start = open.start;
+    span.duration = c.last - open.start;
+
+    for (unsigned i = 0; i < phases; i ++)
+	span.spent[i] = c.spent[i] - open.spent[i];
+
+    for (unsigned i = 0; i < events; i ++) {
+	span.counts[i] = -open.counts[i];
+
+	for (unsigned j = 0; j < phases; j ++)
+	    span.counts[i] += c.counts[j][i];
+    }
+
+    c.spans.push_back(move(span));
+    c.open.pop_back();
+}
+
+
+/*
+ * Function:	Clock::Clock (constructor)
+ *
+ * Description:	Start the clock of a thread in the parse phase, opening
+ *		the counters of the thread as a group if we are counting.
+ */
+
+Clock::Clock()
+    : phase(Phase::PARSE), thread(threads ++), last(now())
+{
+    struct perf_event_attr attr;
+
+
+    memset(spent, 0, sizeof(spent));
+    memset(counts, 0, sizeof(counts));
+    memset(values, 0, sizeof(values));
+    fill(fds, fds + events, -1);
+
+    for (unsigned i = 0; counting && i < events; i ++) {
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = counters[i].config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+
+	fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, fds[0], 0);
+
+	if (fds[i] < 0) {
+	    for (unsigned j = 0; j < i; j ++)
+		::close(fds[j]);
+
+	    fill(fds, fds + events, -1);
+	    counted = false;
+	    break;
+	}
+    }
+
+    sample(fds, values);
+}
+
+
+/*
+ * Function:	Clock::~Clock (destructor)
+ *
+ * Description:	Stop the clock of a thread, ending any spans still open,
+ *		and add its times and spans to the totals.
+ */
+
+Clock::~Clock()
+{
+    charge(*this);
+
+    while (!open.empty())
+	close(*this);
+
+    lock_guard<mutex> guard(merging);
+
+    for (unsigned i = 0; i < phases; i ++) {
+	::spent[i] += spent[i];
+
+	for (unsigned j = 0; j < events; j ++)
+	    ::counts[i][j] += counts[i][j];
+    }
+
+    for (auto &span : spans)
+	::spans.push_back(span);
+
+    for (unsigned i = 0; i < events; i ++)
+	if (fds[i] >= 0)
+	    ::close(fds[i]);
+}
+
+
+/*
+ * Function:	enterPhase
+ *
+ * Description:	Put the calling thread in the given phase, charging the
+ *		time and counts since the last change to the phase it was
+ *		in, and return that phase.
+ */
+
+Phase enterPhase(Phase phase)
+{
+    Clock &c = stopwatch;
+    Phase old = c.phase;
+
+
+    charge(c);
+    c.phase = phase;
+    return old;
+}
+
+
+/*
+ * Function:	beginSpan
+ *
+ * Description:	Begin a span of the given category and name on the calling
+ *		thread.
+ */
+
+void beginSpan(const char *category, const string &name)
+{
+    Clock &c = stopwatch;
+    Open open;
+
+
+    charge(c);
+    open.category = category;
+    open.name = name;
+    open.start = c.last;
+    memcpy(open.spent, c.spent, sizeof(open.spent));
+
+    for (unsigned i = 0; i < events; i ++) {
+	open.counts[i] = 0;
+
+	for (unsigned j = 0; j < phases; j ++)
+	    open.counts[i] += c.counts[j][i];
+    }
+
+    c.open.push_back(open);
+}
+
+
+/*
+ * Function:	endSpan
+ *
+ * Description:	End the span begun last on the calling thread.
+ */
+
+void endSpan()
+{
+    close(stopwatch);
+}
+
+
+/*
+ * Function:	writeReport
+ *
+ * Description:	Write the time and counts of each phase as a table.
+ */
+
+static void writeReport(ostream &ostr, uint64_t wall)
+{
+    bool counters = counting && counted;
+    uint64_t total = 0, sums[events] = {0};
+    char buf[128];
+
+
+    for (unsigned i = 0; i < phases; i ++) {
+	total += spent[i];
+
+	for (unsigned j = 0; j < events; j ++)
+	    sums[j] += counts[i][j];
+    }
+
+    ostr << "scc: time report, " << threads << (threads == 1 ? " thread" : " threads") << "\n";
+    snprintf(buf, sizeof(buf), "%-8s %12s %7s", "phase", "time (ms)", "%");
+    ostr << buf;
+
+    for (unsigned j = 0; counters && j < events; j ++) {
+	snprintf(buf, sizeof(buf), " %15s", ::counters[j].name);
+	ostr << buf;
+    }
+
+    ostr << "\n";
+
+    for (unsigned i = 0; i <= phases; i ++) {
+	uint64_t time = i < phases ? spent[i] : total;
+
+	snprintf(buf, sizeof(buf), "%-8s %12.3f %6.1f%%", i < phases ? names[i] : "total",
+		time / 1e6, total > 0 ? 100.0 * time / total : 0.0);
+	ostr << buf;
+
+	for (unsigned j = 0; counters && j < events; j ++) {
+	    snprintf(buf, sizeof(buf), " %15llu",
+		    (unsigned long long) (i < phases ? counts[i][j] : sums[j]));
+	    ostr << buf;
+	}
+
+	ostr << "\n";
+    }
+
+    snprintf(buf, sizeof(buf), "%-8s %12.3f\n", "wall", wall / 1e6);
+    ostr << buf;
+
+    if (counting && !counted)
+	ostr << "scc: hardware counters are not available" << endl;
+
+    ostr << flush;
+}
+
+
+/*
+ * Function:	writeTrace
+ *
+ * Description:	Write the spans as a Chrome trace, with times in
+ *		microseconds.  The time and counts of each phase during a
+ *		span are its arguments.
+ */
+
+static void writeTrace(ostream &ostr)
+{
+    bool counters = counting && counted;
+    char buf[64];
+
+
+    sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) {
+	return a.thread != b.thread ? a.thread < b.thread : a.start < b.start;
+    });
+
+    ostr << "{\"traceEvents\": [\n";
+
+    for (unsigned i = 0; i < threads; i ++)
+	ostr << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+	    << ", \"args\": {\"name\": \"" << (i == 0 ? "main" : "thread") << "\"}},\n";
+
+    for (auto &span : spans) {
+	ostr << "{\"name\": ";
+	Diagnostics::escape(ostr, span.name);
+	snprintf(buf, sizeof(buf), "%.3f, \"dur\": %.3f", span.start / 1e3, span.duration / 1e3);
+	ostr << ", \"cat\": \"" << span.category << "\", \"ph\": \"X\", \"pid\": 1";
+	ostr << ", \"tid\": " << span.thread << ", \"ts\": " << buf << ", \"args\": {";
+
+	for (unsigned i = 0; i < phases; i ++) {
+	    snprintf(buf, sizeof(buf), "%.3f", span.spent[i] / 1e3);
+	    ostr << (i > 0 ? ", " : "") << "\"" << names[i] << "\": " << buf;
+	}
+
+	for (unsigned i = 0; counters && i < events; i ++)
+	    ostr << ", \"" << ::counters[i].name << "\": " << span.counts[i];
+
+	ostr << "}},\n";
+    }
+
+    ostr << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, ";
+    ostr << "\"args\": {\"name\": \"scc\"}}\n";
+    ostr << "], \"displayTimeUnit\": \"ms\"}" << endl;
+}
+
+
+/*
+ * Function:	writeTiming
+ *
+ * Description:	Write the report and the trace, as asked.  This is called
+ *		at exit, once the main thread has added its times.
+ */
+
+static void writeTiming()
+{
+    uint64_t wall = now();
+    ofstream file;
+
+
+    if (reporting)
+	writeReport(cerr, wall);
+
+    if (path != nullptr) {
+	file.open(path);
+
+	if (file)
+	    writeTrace(file);
+
+	if (!file)
+	    cerr << "scc: cannot write " << path << endl;
+    }
+}
+
+
+/*
+ * Function:	startTiming
+ *
+ * Description:	Start timing the phases, reporting them at exit if asked,
+ *		counting the work of each if asked, and writing a trace to
+ *		the given path if there is one.
+ */
+
+void startTiming(bool report, bool count, const char *trace)
+{
+    origin = steady_clock::now();
+    reporting = report;
+    counting = count;
+    path = trace;
+    timing = true;
+    atexit(writeTiming);
+}
@@ -0,0 +1,76 @@
+/*
+ * File:	timing.h
+ *
+ * Description:	This file contains the definitions for timing the phases
+ *		of Simple C, as asked for with -ftime-report and
+ *		-ftime-trace.  Each thread is always in one of the phases:
+ *
+ *		lex	reading tokens
+ *		parse	anything not in another phase
+ *		scope	opening and closing scopes, and declaring and
+ *			looking up symbols
+ *		check	checking the types of expressions and statements
+ *		output	writing the output and diagnostics
+ *		wait	waiting for other threads to finish
+ *
+ *		A phase timer puts the thread in its phase for as long as
+ *		it lives, and then back in the phase it was in, so time is
+ *		only ever charged to the innermost phase.  A span timer
+ *		marks a stretch of work, such as checking a function body,
+ *		as an event of a Chrome trace, along with the time spent in
+ *		each phase during it.
+ *
+ *		Unless timing was asked for, every timer costs only a test
+ *		of a flag.  The timers are inlined even when
+ *		not optimizing, since otherwise the calls to make and
+ *		destroy them would cost more than the work they time.
+ */
+
+# ifndef TIMING_H
+# define TIMING_H
+# include <string>
+
+# define TIMER_INLINE __attribute__((always_inline))
+
+enum class Phase : unsigned char {
+    LEX, PARSE, SCOPE, CHECK, OUTPUT, WAIT, PHASES
+};
+
+extern bool timing;
+
+Phase enterPhase(Phase phase);
+void beginSpan(const char *category, const std::string &name);
+void endSpan();
+void startTiming(bool reporting, bool counting, const char *path);
+
+class PhaseTimer {
+    Phase _previous;
+
+public:
+    explicit PhaseTimer(Phase phase) TIMER_INLINE : _previous(phase) {
+	if (timing)
+	    _previous = enterPhase(phase);
+    }
+
+    ~PhaseTimer() TIMER_INLINE {
+	if (timing)
+	    enterPhase(_previous);
+    }
+};
+
+class SpanTimer {
+    bool _open;
+
+public:
+    SpanTimer(const char *category, const std::string &name) TIMER_INLINE : _open(timing) {
+	if (_open)
+	    beginSpan(category, name);
+    }
+
+    ~SpanTimer() TIMER_INLINE {
+	if (_open)
+	    endSpan();
+    }
+};
+
+# endif /* TIMING_H */
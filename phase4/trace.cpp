@@ -0,0 +1,130 @@
+/*
+ * File:	trace.cpp
+ *
+ * Description:	This file contains the definitions of the trace sinks for
+ *		Simple C that actually write something.
+ */
+
+# include <iostream>
+# include "tokens.h"
+# include "trace.h"
+
+using namespace std;
+
+thread_local ostream *output = &cout;
+
+static const char *names[] = {
+    "mul", "div", "rem", "add", "sub", "ltn", "gtn", "leq", "geq", "eql",
+    "neq", "and", "or", "not", "neg", "deref", "addr", "sizeof", "index",
+};
+
+
+/*
+ * Function:	TextTrace::event
+ *
+ * Description:	Write the name of the event on a line by itself.  We don't
+ *		flush the stream, which is most of the cost of tracing.
+ */
+
+void TextTrace::event(ostream &ostr, Event event)
+{
+    ostr << names[(unsigned) event] << '\n';
+}
+
+
+/*
+ * Function:	TextTrace::declaration
+ *
+ * Description:	Write the name and type of a declaration on a line by
+ *		itself.
+ */
+
+void TextTrace::declaration(ostream &ostr, const string &name, const Type &type)
+{
+    ostr << name << ": " << type << '\n';
+}
+
+
+/*
+ * Function:	writeNumber
+ *
+ * Description:	Write an unsigned number seven bits at a time.
+ */
+
+static void writeNumber(ostream &ostr, unsigned long n)
+{
+    while (n >= 0x80) {
+	ostr.put((n & 0x7f) | 0x80);
+	n >>= 7;
+    }
+
+    ostr.put(n);
+}
+
+
+/*
+ * Function:	writeType
+ *
+ * Description:	Write a type in binary.  The specifier is written as its
+ *		offset from the first keyword token.
+ */
+
+static void writeType(ostream &ostr, const Type &type)
+{
+    if (type.isError()) {
+	ostr.put(0);
+	return;
+    }
+
+    writeNumber(ostr, type.specifier() - AUTO + 1);
+
+    if (type.isArray()) {
+	ostr.put(1);
+	writeNumber(ostr, type.indirection());
+	writeNumber(ostr, type.length());
+
+    } else if (type.isFunction() && type.parameters() == nullptr) {
+	ostr.put(3);
+	writeNumber(ostr, type.indirection());
+	writeNumber(ostr, 0);
+
+    } else if (type.isFunction()) {
+	ostr.put(2);
+	writeNumber(ostr, type.indirection());
+	writeNumber(ostr, type.parameters()->size());
+
+	for (auto &parameter : *type.parameters())
+	    writeType(ostr, parameter);
+
+    } else {
+	ostr.put(0);
+	writeNumber(ostr, type.indirection());
+    }
+}
+
+
+/*
+ * Function:	BinaryTrace::event
+ *
+ * Description:	Write an event as a single byte.
+ */
+
+void BinaryTrace::event(ostream &ostr, Event event)
+{
+    ostr.put((char) event);
+}
+
+
+/*
+ * Function:	BinaryTrace::declaration
+ *
+ * Description:	Write a declaration event followed by its name and type.
+ */
+
+void BinaryTrace::declaration(ostream &ostr, const string &name, const Type &type)
+{
+    ostr.put((char) Event::DECLARATION);
+    writeNumber(ostr, name.size());
+    ostr.write(name.data(), name.size());
+    writeType(ostr, type);
+}
@@ -0,0 +1,77 @@
+/*
+ * File:	trace.h
+ *
+ * Description:	This file contains the definitions for tracing the parser
+ *		and checker for Simple C.  Each operator that is parsed and
+ *		each declaration that is checked is an event, which is sent
+ *		to a trace sink chosen at compile time by defining TRACE:
+ *
+ *		NoTrace		discards all events (the default)
+ *		TextTrace	writes one line per event, as in "mul" or
+ *				"x: int *"
+ *		BinaryTrace	writes a compact binary stream of events
+ *
+ *		A binary event is a single byte giving the event.  A
+ *		declaration is followed by the length and characters of the
+ *		name and then the type.  A type is its specifier as an
+ *		offset from AUTO plus one, or zero for the error type,
+ *		followed by a declarator (0 scalar, 1 array, 2 function, 3
+ *		function with unspecified parameters), the indirection,
+ *		and then the array length or the number of parameters and
+ *		their types.  All numbers are written seven bits at a time,
+ *		low bits first, with the high bit set on all but the last.
+ *
+ *		Events are written to the output stream of the calling
+ *		thread, which is the standard output unless the thread is
+ *		collecting its own output.
+ *
+ *		The sinks are policies with static members, so with the
+ *		default sink every trace call compiles to nothing.
+ */
+
+# ifndef TRACE_H
+# define TRACE_H
+# include <ostream>
+# include <string>
+# include "Type.h"
+
+# ifndef TRACE
+# define TRACE NoTrace
+# endif
+
+extern thread_local std::ostream *output;
+
+enum class Event : unsigned char {
+    MUL, DIV, REM, ADD, SUB, LTN, GTN, LEQ, GEQ, EQL, NEQ, AND, OR,
+    NOT, NEG, DEREF, ADDR, SIZEOF, INDEX, DECLARATION
+};
+
+struct NoTrace {
+    static void event(std::ostream &, Event) {}
+    static void declaration(std::ostream &, const std::string &, const Type &) {}
+};
+
+struct TextTrace {
+    static void event(std::ostream &ostr, Event event);
+    static void declaration(std::ostream &ostr, const std::string &name, const Type &type);
+};
+
+struct BinaryTrace {
+    static void event(std::ostream &ostr, Event event);
+    static void declaration(std::ostream &ostr, const std::string &name, const Type &type);
+};
+
+template <class Sink>
+struct Tracer {
+    static void event(Event event) {
+	Sink::event(*output, event);
+    }
+
+    static void declaration(const std::string &name, const Type &type) {
+	Sink::declaration(*output, name, type);
+    }
+};
+
+typedef Tracer<TRACE> trace;
+
+# endif /* TRACE_H */